@@ -0,0 +1,121 @@
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "abu/feed.h"
+
+namespace {
+std::vector<char> get_text_data(std::size_t n) {
+  std::vector<char> result(n, 'a');
+  for (std::size_t i = 79; i < n; i += 80) {
+    result[i - 1] = '\r';
+    result[i] = '\n';
+  }
+  return result;
+}
+
+abu::feed::stream<std::span<const char>> make_stream(
+    const std::vector<char>& data,
+    std::size_t chunk_len) {
+  abu::feed::stream<std::span<const char>> result;
+  for (std::size_t i = 0; i < data.size(); i += chunk_len) {
+    auto len = std::min(chunk_len, data.size() - i);
+    result.append(std::span<const char>{data.data() + i, len});
+  }
+  result.finish();
+  return result;
+}
+}  // namespace
+
+static void BM_count_newlines_memchr(benchmark::State& state) {
+  auto data = get_text_data(static_cast<std::size_t>(state.range(0)));
+
+  for (auto _ : state) {
+    std::size_t count = 0;
+    const char* pos = data.data();
+    const char* end = data.data() + data.size();
+    while (auto* found = static_cast<const char*>(
+               std::memchr(pos, '\n', static_cast<std::size_t>(end - pos)))) {
+      ++count;
+      pos = found + 1;
+    }
+    benchmark::DoNotOptimize(count);
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_count_newlines_memchr)->Range(1 << 10, 1 << 24);
+
+static void BM_count_newlines_per_element(benchmark::State& state) {
+  auto data = get_text_data(static_cast<std::size_t>(state.range(0)));
+  auto stream = make_stream(data, 4096);
+  auto cp = stream.checkpoint();
+
+  for (auto _ : state) {
+    stream.rollback(cp);
+    std::size_t count = 0;
+    while (stream != abu::feed::empty) {
+      if (*stream == '\n') {
+        ++count;
+      }
+      ++stream;
+    }
+    benchmark::DoNotOptimize(count);
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_count_newlines_per_element)->Range(1 << 10, 1 << 24);
+
+static void BM_count_newlines_feed(benchmark::State& state) {
+  auto data = get_text_data(static_cast<std::size_t>(state.range(0)));
+  auto stream = make_stream(data, 4096);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(abu::feed::count(stream, '\n'));
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_count_newlines_feed)->Range(1 << 10, 1 << 24);
+
+static void BM_skip_lines_per_element(benchmark::State& state) {
+  auto data = get_text_data(static_cast<std::size_t>(state.range(0)));
+  auto stream = make_stream(data, 4096);
+  auto cp = stream.checkpoint();
+
+  for (auto _ : state) {
+    stream.rollback(cp);
+    std::size_t lines = 0;
+    char prev = 0;
+    while (stream != abu::feed::empty) {
+      if (prev == '\r' && *stream == '\n') {
+        ++lines;
+      }
+      prev = *stream;
+      ++stream;
+    }
+    benchmark::DoNotOptimize(lines);
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_skip_lines_per_element)->Range(1 << 10, 1 << 24);
+
+static void BM_skip_lines_feed(benchmark::State& state) {
+  using namespace std::literals;
+  auto data = get_text_data(static_cast<std::size_t>(state.range(0)));
+  auto stream = make_stream(data, 4096);
+  auto cp = stream.checkpoint();
+
+  for (auto _ : state) {
+    stream.rollback(cp);
+    std::size_t lines = 0;
+    while (abu::feed::skip_until(stream, "\r\n"sv)) {
+      ++lines;
+      stream.advance(2);
+    }
+    benchmark::DoNotOptimize(lines);
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_skip_lines_feed)->Range(1 << 10, 1 << 24);
@@ -0,0 +1,93 @@
+#include <benchmark/benchmark.h>
+
+#include <functional>
+#include <span>
+#include <vector>
+
+#include "abu/feed.h"
+
+namespace {
+std::vector<int> get_int_data(std::size_t n) {
+  return std::vector<int>(n, 12);
+}
+
+int accumulate(abu::Feed auto& feed) {
+  int accum = 0;
+  while (feed != abu::feed::empty) {
+    accum += *feed;
+    ++feed;
+  }
+  return accum;
+}
+
+abu::feed::stream<std::span<const int>> make_stream(
+    const std::vector<int>& data,
+    std::size_t chunk_len) {
+  abu::feed::stream<std::span<const int>> result;
+  for (std::size_t i = 0; i < data.size(); i += chunk_len) {
+    auto len = std::min(chunk_len, data.size() - i);
+    result.append(std::span<const int>{data.data() + i, len});
+  }
+  result.finish();
+  return result;
+}
+}  // namespace
+
+static void BM_any_feed_adapted(benchmark::State& state) {
+  auto data = get_int_data(static_cast<std::size_t>(state.range(0)));
+
+  for (auto _ : state) {
+    auto adapted = abu::feed::adapt_range(data);
+    benchmark::DoNotOptimize(accumulate(adapted));
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_any_feed_adapted)->Range(1024, 1 << 20);
+
+static void BM_any_feed_adapted_erased(benchmark::State& state) {
+  auto data = get_int_data(static_cast<std::size_t>(state.range(0)));
+
+  for (auto _ : state) {
+    abu::feed::any_feed<int> erased{abu::feed::adapt_range(data)};
+    benchmark::DoNotOptimize(accumulate(erased));
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_any_feed_adapted_erased)->Range(1024, 1 << 20);
+
+static void BM_any_feed_stream(benchmark::State& state) {
+  auto data = get_int_data(1 << 20);
+  auto chunk_len = static_cast<std::size_t>(state.range(0));
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto stream = make_stream(data, chunk_len);
+    state.ResumeTiming();
+
+    benchmark::DoNotOptimize(accumulate(stream));
+  }
+
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<std::int64_t>(data.size()));
+}
+BENCHMARK(BM_any_feed_stream)->RangeMultiplier(16)->Range(16, 65536);
+
+static void BM_any_feed_stream_erased(benchmark::State& state) {
+  auto data = get_int_data(1 << 20);
+  auto chunk_len = static_cast<std::size_t>(state.range(0));
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto stream = make_stream(data, chunk_len);
+    state.ResumeTiming();
+
+    abu::feed::any_feed<int> erased{std::ref(stream)};
+    benchmark::DoNotOptimize(accumulate(erased));
+  }
+
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<std::int64_t>(data.size()));
+}
+BENCHMARK(BM_any_feed_stream_erased)->RangeMultiplier(16)->Range(16, 65536);
@@ -0,0 +1,126 @@
+#include <benchmark/benchmark.h>
+
+#include <functional>
+#include <span>
+#include <vector>
+
+#include "abu/feed.h"
+
+namespace {
+std::vector<char> get_mixed_case_data(std::size_t n) {
+  std::vector<char> result(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    result[i] = static_cast<char>((i % 2 ? 'a' : 'A') + i % 26);
+  }
+  return result;
+}
+
+abu::feed::stream<std::span<const char>> make_stream(
+    const std::vector<char>& data,
+    std::size_t chunk_len) {
+  abu::feed::stream<std::span<const char>> result;
+  for (std::size_t i = 0; i < data.size(); i += chunk_len) {
+    auto len = std::min(chunk_len, data.size() - i);
+    result.append(std::span<const char>{data.data() + i, len});
+  }
+  result.finish();
+  return result;
+}
+
+char to_lower(char c) {
+  return c >= 'A' && c <= 'Z' ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+template <typename F>
+int accumulate_blocks(F& data) {
+  int accum = 0;
+  while (data != abu::feed::empty) {
+    auto block = data.current_span();
+    for (auto c : block) {
+      accum += c;
+    }
+    data.advance(std::ssize(block));
+  }
+  return accum;
+}
+}  // namespace
+
+static void BM_lowercase_per_element(benchmark::State& state) {
+  auto data = get_mixed_case_data(1 << 20);
+  auto chunk_len = static_cast<std::size_t>(state.range(0));
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto stream = make_stream(data, chunk_len);
+    state.ResumeTiming();
+
+    int accum = 0;
+    while (stream != abu::feed::empty) {
+      accum += to_lower(*stream);
+      ++stream;
+    }
+    benchmark::DoNotOptimize(accum);
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<std::int64_t>(data.size()));
+}
+BENCHMARK(BM_lowercase_per_element)->RangeMultiplier(16)->Range(256, 65536);
+
+static void BM_lowercase_transform(benchmark::State& state) {
+  auto data = get_mixed_case_data(1 << 20);
+  auto chunk_len = static_cast<std::size_t>(state.range(0));
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto stream = make_stream(data, chunk_len);
+    state.ResumeTiming();
+
+    auto lower = abu::feed::transform(std::ref(stream),
+                                      [](char c) { return to_lower(c); });
+    benchmark::DoNotOptimize(accumulate_blocks(lower));
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<std::int64_t>(data.size()));
+}
+BENCHMARK(BM_lowercase_transform)->RangeMultiplier(16)->Range(256, 65536);
+
+static void BM_filter_per_element(benchmark::State& state) {
+  auto data = get_mixed_case_data(1 << 20);
+  auto chunk_len = static_cast<std::size_t>(state.range(0));
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto stream = make_stream(data, chunk_len);
+    state.ResumeTiming();
+
+    int accum = 0;
+    while (stream != abu::feed::empty) {
+      if (*stream >= 'a') {
+        accum += *stream;
+      }
+      ++stream;
+    }
+    benchmark::DoNotOptimize(accum);
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<std::int64_t>(data.size()));
+}
+BENCHMARK(BM_filter_per_element)->RangeMultiplier(16)->Range(256, 65536);
+
+static void BM_filter(benchmark::State& state) {
+  auto data = get_mixed_case_data(1 << 20);
+  auto chunk_len = static_cast<std::size_t>(state.range(0));
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto stream = make_stream(data, chunk_len);
+    state.ResumeTiming();
+
+    auto lower = abu::feed::filter(std::ref(stream),
+                                   [](char c) { return c >= 'a'; });
+    benchmark::DoNotOptimize(accumulate_blocks(lower));
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<std::int64_t>(data.size()));
+}
+BENCHMARK(BM_filter)->RangeMultiplier(16)->Range(256, 65536);
@@ -0,0 +1,87 @@
+#include <benchmark/benchmark.h>
+
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "abu/feed.h"
+
+using namespace std::literals;
+
+namespace {
+std::vector<char> get_line_data(std::size_t n) {
+  std::vector<char> result(n, 'a');
+  for (std::size_t i = 79; i < n; i += 80) {
+    result[i] = '\n';
+  }
+  return result;
+}
+
+std::vector<char> get_record_data(std::size_t n) {
+  constexpr std::size_t record_len = 80;
+  std::vector<char> result;
+  while (result.size() + 4 + record_len <= n) {
+    result.insert(result.end(), {0, 0, 0, static_cast<char>(record_len)});
+    result.insert(result.end(), record_len, 'a');
+  }
+  return result;
+}
+
+abu::feed::stream<std::span<const char>> make_stream(
+    const std::vector<char>& data,
+    std::size_t chunk_len) {
+  abu::feed::stream<std::span<const char>> result;
+  for (std::size_t i = 0; i < data.size(); i += chunk_len) {
+    auto len = std::min(chunk_len, data.size() - i);
+    result.append(std::span<const char>{data.data() + i, len});
+  }
+  result.finish();
+  return result;
+}
+
+template <typename FramingT>
+std::size_t total_frame_size(abu::feed::stream<std::span<const char>>& data,
+                             FramingT framing) {
+  abu::feed::frame_reader frames{data, std::move(framing)};
+  std::size_t result = 0;
+  while (frames != abu::feed::empty) {
+    result += (*frames).size();
+    ++frames;
+  }
+  return result;
+}
+}  // namespace
+
+static void BM_framing_delimited(benchmark::State& state) {
+  auto data = get_line_data(1 << 20);
+  auto chunk_len = static_cast<std::size_t>(state.range(0));
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto stream = make_stream(data, chunk_len);
+    state.ResumeTiming();
+
+    benchmark::DoNotOptimize(
+        total_frame_size(stream, abu::feed::delimited_framing{"\n"sv}));
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<std::int64_t>(data.size()));
+}
+BENCHMARK(BM_framing_delimited)->RangeMultiplier(16)->Range(64, 65536);
+
+static void BM_framing_be32_length(benchmark::State& state) {
+  auto data = get_record_data(1 << 20);
+  auto chunk_len = static_cast<std::size_t>(state.range(0));
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto stream = make_stream(data, chunk_len);
+    state.ResumeTiming();
+
+    benchmark::DoNotOptimize(
+        total_frame_size(stream, abu::feed::be32_length_framing{}));
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<std::int64_t>(data.size()));
+}
+BENCHMARK(BM_framing_be32_length)->RangeMultiplier(16)->Range(64, 65536);
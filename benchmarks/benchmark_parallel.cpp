@@ -0,0 +1,67 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <functional>
+#include <span>
+#include <vector>
+
+#include "abu/feed.h"
+
+namespace {
+std::vector<char> get_line_data(std::size_t n) {
+  std::vector<char> result(n, 'a');
+  for (std::size_t i = 79; i < n; i += 80) {
+    result[i] = '\n';
+  }
+  return result;
+}
+
+abu::feed::stream<std::span<const char>> make_stream(
+    const std::vector<char>& data,
+    std::size_t chunk_len) {
+  abu::feed::stream<std::span<const char>> result;
+  for (std::size_t i = 0; i < data.size(); i += chunk_len) {
+    auto len = std::min(chunk_len, data.size() - i);
+    result.append(std::span<const char>{data.data() + i, len});
+  }
+  result.finish();
+  return result;
+}
+
+bool is_newline(char c) {
+  return c == '\n';
+}
+
+// Deliberately element-wise, to stand in for an actual parser.
+std::size_t count_lines(abu::Feed auto& data) {
+  std::size_t result = 0;
+  while (data != abu::feed::empty) {
+    if (*data == '\n') {
+      ++result;
+    }
+    ++data;
+  }
+  return result;
+}
+}  // namespace
+
+static void BM_parallel_segments(benchmark::State& state) {
+  auto data = get_line_data(1 << 24);
+  auto stream = make_stream(data, 65536);
+  auto n = static_cast<std::size_t>(state.range(0));
+
+  for (auto _ : state) {
+    auto segments = abu::feed::split(stream, n, is_newline);
+    benchmark::DoNotOptimize(abu::feed::parse_in_parallel(
+        segments,
+        [](auto& feed) { return count_lines(feed); },
+        std::size_t{0},
+        std::plus<>{}));
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<std::int64_t>(data.size()));
+}
+BENCHMARK(BM_parallel_segments)
+    ->RangeMultiplier(2)
+    ->Range(1, 16)
+    ->UseRealTime();
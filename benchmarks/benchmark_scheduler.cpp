@@ -0,0 +1,101 @@
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "abu/feed.h"
+
+namespace {
+constexpr std::size_t connection_count = 1000;
+constexpr std::size_t read_count = 20000;
+constexpr std::size_t read_len = 1024;
+
+std::vector<char> get_line_data(std::size_t n) {
+  std::vector<char> result(n, 'a');
+  for (std::size_t i = 79; i < n; i += 80) {
+    result[i] = '\n';
+  }
+  return result;
+}
+
+// Deliberately element-wise, to stand in for an actual parser.
+struct connection {
+  void resume() {
+    while (data != abu::feed::empty) {
+      if (*data == '\n') {
+        ++lines;
+      }
+      ++data;
+    }
+  }
+
+  abu::feed::concurrent_stream<std::span<const char>> data;
+  std::size_t lines = 0;
+};
+
+std::vector<std::unique_ptr<connection>> make_connections() {
+  std::vector<std::unique_ptr<connection>> result;
+  for (std::size_t i = 0; i < connection_count; ++i) {
+    result.push_back(std::make_unique<connection>());
+  }
+  return result;
+}
+}  // namespace
+
+// What a single parse loop does: every connection gets polled after each
+// read, whether it got anything or not.
+static void BM_connections_polled(benchmark::State& state) {
+  auto data = get_line_data(read_len);
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto connections = make_connections();
+    state.ResumeTiming();
+
+    for (std::size_t i = 0; i < read_count; ++i) {
+      auto& target = *connections[i % connection_count];
+      target.data.append(std::span<const char>{data});
+      for (auto& conn : connections) {
+        conn->resume();
+      }
+    }
+    benchmark::DoNotOptimize(connections.front()->lines);
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<std::int64_t>(read_count * read_len));
+}
+BENCHMARK(BM_connections_polled)->UseRealTime();
+
+static void BM_connections_scheduled(benchmark::State& state) {
+  auto data = get_line_data(read_len);
+  abu::feed::resume_scheduler scheduler{
+      static_cast<std::size_t>(state.range(0))};
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto connections = make_connections();
+    std::vector<abu::feed::resume_scheduler::handle> ids;
+    for (auto& conn : connections) {
+      ids.push_back(scheduler.add([c = conn.get()] { c->resume(); }));
+    }
+    state.ResumeTiming();
+
+    for (std::size_t i = 0; i < read_count; ++i) {
+      auto& target = *connections[i % connection_count];
+      target.data.append(std::span<const char>{data});
+      scheduler.notify(ids[i % connection_count]);
+    }
+    scheduler.wait_idle();
+    benchmark::DoNotOptimize(connections.front()->lines);
+
+    state.PauseTiming();
+    ids.clear();
+    state.ResumeTiming();
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<std::int64_t>(read_count * read_len));
+}
+BENCHMARK(BM_connections_scheduled)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
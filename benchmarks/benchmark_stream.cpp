@@ -0,0 +1,342 @@
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <memory_resource>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "abu/feed.h"
+
+namespace {
+std::vector<char> get_char_data(std::size_t n) {
+  return std::vector<char>(n, 'a');
+}
+
+// Words of 1 to 16 characters, separated by spaces.
+std::vector<char> get_word_data(std::size_t n) {
+  std::vector<char> result(n, 'a');
+  std::size_t len = 1;
+  for (std::size_t i = 0; i < n; i += len + 1) {
+    len = len % 16 + 1;
+    if (i + len < n) {
+      result[i + len] = ' ';
+    }
+  }
+  return result;
+}
+
+template <typename StreamT>
+int append_and_drain(StreamT& stream,
+                     const std::vector<char>& data,
+                     std::size_t chunk_len) {
+  int accum = 0;
+  for (std::size_t i = 0; i + chunk_len <= data.size(); i += chunk_len) {
+    stream.append(std::span<const char>{data.data() + i, chunk_len});
+    while (stream != abu::feed::empty) {
+      accum += *stream;
+      ++stream;
+    }
+  }
+  return accum;
+}
+
+// Emulates a backtracking parser: every element is tried against a
+// two-element alternative that fails, and then read for real.
+template <typename StreamT>
+void fill_stream(StreamT& stream,
+                 const std::vector<char>& data,
+                 std::size_t chunk_len) {
+  for (std::size_t i = 0; i + chunk_len <= data.size(); i += chunk_len) {
+    stream.append(std::span<const char>{data.data() + i, chunk_len});
+  }
+  stream.finish();
+}
+
+template <typename StreamT>
+int backtrack(StreamT& stream) {
+  int accum = 0;
+  while (stream != abu::feed::empty) {
+    auto cp = stream.checkpoint();
+    accum += *stream;
+    ++stream;
+    stream.rollback(std::move(cp));
+
+    accum += *stream;
+    ++stream;
+  }
+  return accum;
+}
+
+template <typename StreamT>
+int backtrack_scoped(StreamT& stream) {
+  int accum = 0;
+  auto scope = stream.retain();
+  while (stream != abu::feed::empty) {
+    auto cp = stream.scoped_checkpoint();
+    accum += *stream;
+    ++stream;
+    stream.rollback(cp);
+
+    accum += *stream;
+    ++stream;
+  }
+  return accum;
+}
+}  // namespace
+
+static void BM_stream_append_tiny_chunks(benchmark::State& state) {
+  auto data = get_char_data(1 << 20);
+  auto chunk_len = static_cast<std::size_t>(state.range(0));
+
+  for (auto _ : state) {
+    abu::feed::stream<std::span<const char>> stream;
+    benchmark::DoNotOptimize(append_and_drain(stream, data, chunk_len));
+  }
+
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<std::int64_t>(data.size() / chunk_len));
+}
+BENCHMARK(BM_stream_append_tiny_chunks)->RangeMultiplier(4)->Range(4, 256);
+
+static void BM_stream_append_tiny_chunks_track_lines(
+    benchmark::State& state) {
+  auto data = get_char_data(1 << 20);
+  auto chunk_len = static_cast<std::size_t>(state.range(0));
+
+  for (auto _ : state) {
+    abu::feed::stream<std::span<const char>> stream;
+    stream.track_lines();
+    benchmark::DoNotOptimize(append_and_drain(stream, data, chunk_len));
+    benchmark::DoNotOptimize(stream.current_location());
+  }
+
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<std::int64_t>(data.size() / chunk_len));
+}
+BENCHMARK(BM_stream_append_tiny_chunks_track_lines)
+    ->RangeMultiplier(4)
+    ->Range(4, 256);
+
+static void BM_stream_append_tiny_chunks_pooled(benchmark::State& state) {
+  auto data = get_char_data(1 << 20);
+  auto chunk_len = static_cast<std::size_t>(state.range(0));
+
+  std::pmr::unsynchronized_pool_resource pool;
+  using alloc_t = std::pmr::polymorphic_allocator<std::span<const char>>;
+
+  for (auto _ : state) {
+    abu::feed::stream<std::span<const char>, alloc_t> stream{&pool};
+    benchmark::DoNotOptimize(append_and_drain(stream, data, chunk_len));
+  }
+
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<std::int64_t>(data.size() / chunk_len));
+}
+BENCHMARK(BM_stream_append_tiny_chunks_pooled)
+    ->RangeMultiplier(4)
+    ->Range(4, 256);
+
+static void BM_stream_append_tiny_chunks_node_pool(benchmark::State& state) {
+  auto data = get_char_data(1 << 20);
+  auto chunk_len = static_cast<std::size_t>(state.range(0));
+
+  abu::feed::node_pool pool;
+  using alloc_t = abu::feed::node_pool_allocator<std::span<const char>>;
+
+  for (auto _ : state) {
+    abu::feed::stream<std::span<const char>, alloc_t> stream{&pool};
+    benchmark::DoNotOptimize(append_and_drain(stream, data, chunk_len));
+  }
+
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<std::int64_t>(data.size() / chunk_len));
+}
+BENCHMARK(BM_stream_append_tiny_chunks_node_pool)
+    ->RangeMultiplier(4)
+    ->Range(4, 256);
+
+static void BM_stream_append_tiny_chunks_coalescing(benchmark::State& state) {
+  auto data = get_char_data(1 << 20);
+  auto chunk_len = static_cast<std::size_t>(state.range(0));
+
+  for (auto _ : state) {
+    abu::feed::coalescing_stream<std::span<const char>> stream;
+    benchmark::DoNotOptimize(append_and_drain(stream, data, chunk_len));
+  }
+
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<std::int64_t>(data.size() / chunk_len));
+}
+BENCHMARK(BM_stream_append_tiny_chunks_coalescing)
+    ->RangeMultiplier(4)
+    ->Range(4, 256);
+
+// Emulates reads from a socket, which come in whatever size they please.
+static void BM_stream_reads_owned_chunks(benchmark::State& state) {
+  auto data = get_char_data(1 << 20);
+  auto read_len = static_cast<std::size_t>(state.range(0));
+
+  for (auto _ : state) {
+    abu::feed::stream<std::vector<char>> stream;
+    int accum = 0;
+    for (std::size_t i = 0; i + read_len <= data.size(); i += read_len) {
+      std::vector<char> chunk(read_len);
+      std::memcpy(chunk.data(), data.data() + i, read_len);
+      stream.append(std::move(chunk));
+      while (stream != abu::feed::empty) {
+        accum += *stream;
+        ++stream;
+      }
+    }
+    benchmark::DoNotOptimize(accum);
+  }
+
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<std::int64_t>(data.size()));
+}
+BENCHMARK(BM_stream_reads_owned_chunks)->RangeMultiplier(4)->Range(64, 4096);
+
+static void BM_stream_reads_prepare_commit(benchmark::State& state) {
+  auto data = get_char_data(1 << 20);
+  auto read_len = static_cast<std::size_t>(state.range(0));
+
+  for (auto _ : state) {
+    abu::feed::coalescing_stream<std::vector<char>> stream;
+    int accum = 0;
+    for (std::size_t i = 0; i + read_len <= data.size(); i += read_len) {
+      auto buffer = stream.prepare(read_len);
+      std::memcpy(buffer.data(), data.data() + i, read_len);
+      stream.commit(read_len);
+      while (stream != abu::feed::empty) {
+        accum += *stream;
+        ++stream;
+      }
+    }
+    benchmark::DoNotOptimize(accum);
+  }
+
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<std::int64_t>(data.size()));
+}
+BENCHMARK(BM_stream_reads_prepare_commit)->RangeMultiplier(4)->Range(64, 4096);
+
+static void BM_stream_backtracking(benchmark::State& state) {
+  auto data = get_char_data(1 << 20);
+  auto chunk_len = static_cast<std::size_t>(state.range(0));
+
+  for (auto _ : state) {
+    abu::feed::stream<std::span<const char>> stream;
+    fill_stream(stream, data, chunk_len);
+    benchmark::DoNotOptimize(backtrack(stream));
+  }
+
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<std::int64_t>(data.size()));
+}
+BENCHMARK(BM_stream_backtracking)->RangeMultiplier(16)->Range(16, 4096);
+
+static void BM_stream_backtracking_scoped(benchmark::State& state) {
+  auto data = get_char_data(1 << 20);
+  auto chunk_len = static_cast<std::size_t>(state.range(0));
+
+  for (auto _ : state) {
+    abu::feed::stream<std::span<const char>> stream;
+    fill_stream(stream, data, chunk_len);
+    benchmark::DoNotOptimize(backtrack_scoped(stream));
+  }
+
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<std::int64_t>(data.size()));
+}
+BENCHMARK(BM_stream_backtracking_scoped)
+    ->RangeMultiplier(16)
+    ->Range(16, 4096);
+
+static void BM_stream_accum(benchmark::State& state) {
+  std::vector<int> data(1 << 20, 12);
+  auto chunk_len = static_cast<std::size_t>(state.range(0));
+
+  for (auto _ : state) {
+    abu::feed::stream<std::span<const int>> stream;
+    for (std::size_t i = 0; i + chunk_len <= data.size(); i += chunk_len) {
+      stream.append(std::span<const int>{data.data() + i, chunk_len});
+    }
+    stream.finish();
+
+    int accum = 0;
+    while (stream != abu::feed::end_of_feed) {
+      accum += *stream;
+      ++stream;
+    }
+    benchmark::DoNotOptimize(accum);
+  }
+
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<std::int64_t>(data.size()));
+}
+BENCHMARK(BM_stream_accum)->RangeMultiplier(16)->Range(256, 65536);
+
+// Reads every word of the stream as a token, the way a tokenizer would.
+template <typename ExtractFn>
+std::size_t tokenize(const std::vector<char>& data,
+                     std::size_t chunk_len,
+                     ExtractFn extract) {
+  abu::feed::stream<std::span<const char>> stream;
+  fill_stream(stream, data, chunk_len);
+
+  std::size_t total = 0;
+  while (stream != abu::feed::empty) {
+    auto start = stream.checkpoint();
+    while (stream != abu::feed::empty && *stream != ' ') {
+      ++stream;
+    }
+    total += extract(stream, start);
+    if (stream != abu::feed::empty) {
+      ++stream;
+    }
+  }
+  return total;
+}
+
+static void BM_stream_tokens_copied(benchmark::State& state) {
+  auto data = get_word_data(1 << 20);
+  auto chunk_len = static_cast<std::size_t>(state.range(0));
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        tokenize(data, chunk_len, [](auto& stream, auto start) {
+          std::string token;
+          auto n = stream.distance(start, stream.checkpoint());
+          stream.rollback(std::move(start));
+          for (; n > 0; --n) {
+            token.push_back(*stream);
+            ++stream;
+          }
+          benchmark::DoNotOptimize(token.data());
+          return token.size();
+        }));
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<std::int64_t>(data.size()));
+}
+BENCHMARK(BM_stream_tokens_copied)->RangeMultiplier(16)->Range(256, 65536);
+
+static void BM_stream_tokens_sliced(benchmark::State& state) {
+  auto data = get_word_data(1 << 20);
+  auto chunk_len = static_cast<std::size_t>(state.range(0));
+
+  for (auto _ : state) {
+    std::string scratch;
+    benchmark::DoNotOptimize(
+        tokenize(data, chunk_len, [&](auto& stream, const auto& start) {
+          auto token =
+              stream.slice(start, stream.checkpoint()).materialize(scratch);
+          benchmark::DoNotOptimize(token.data());
+          return token.size();
+        }));
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<std::int64_t>(data.size()));
+}
+BENCHMARK(BM_stream_tokens_sliced)->RangeMultiplier(16)->Range(256, 65536);
@@ -0,0 +1,148 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "abu/feed.h"
+
+using namespace std::literals;
+
+namespace {
+std::vector<char> get_text_data(std::size_t n, std::string_view sample) {
+  std::vector<char> result;
+  result.reserve(n);
+  while (result.size() + sample.size() <= n) {
+    result.insert(result.end(), sample.begin(), sample.end());
+  }
+  return result;
+}
+
+constexpr auto ascii_sample =
+    "The quick brown fox jumps over the lazy dog.\n"sv;
+constexpr auto mixed_sample =
+    "Fran\xc3\xa7ois a pay\xc3\xa9 12\xe2\x82\xac pour un caf\xc3\xa9 "
+    "\xe2\x98\x95 \xf0\x9f\x98\x80\n"sv;
+
+abu::feed::stream<std::span<const char>> make_stream(
+    const std::vector<char>& data,
+    std::size_t chunk_len) {
+  abu::feed::stream<std::span<const char>> result;
+  for (std::size_t i = 0; i < data.size(); i += chunk_len) {
+    auto len = std::min(chunk_len, data.size() - i);
+    result.append(std::span<const char>{data.data() + i, len});
+  }
+  result.finish();
+  return result;
+}
+
+// What consumers did by hand: one byte at a time, tracking how many
+// continuation bytes are still expected.
+bool validate_per_element(abu::feed::stream<std::span<const char>>& data) {
+  int pending = 0;
+  while (data != abu::feed::empty) {
+    auto byte = static_cast<std::uint8_t>(*data);
+    ++data;
+    if (pending > 0) {
+      if ((byte & 0xc0) != 0x80) {
+        return false;
+      }
+      --pending;
+    } else if (byte >= 0x80) {
+      auto len = abu::feed::details_::utf8_sequence_length(byte);
+      if (len == 0) {
+        return false;
+      }
+      pending = static_cast<int>(len) - 1;
+    }
+  }
+  return pending == 0;
+}
+
+template <typename F>
+std::size_t drain_blocks(F& data) {
+  std::size_t total = 0;
+  while (data != abu::feed::empty) {
+    auto block = data.current_span();
+    total += block.size();
+    data.advance(std::ssize(block));
+  }
+  return total;
+}
+
+void run_per_element(benchmark::State& state, std::string_view sample) {
+  auto data = get_text_data(1 << 20, sample);
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto stream = make_stream(data, 4096);
+    state.ResumeTiming();
+
+    benchmark::DoNotOptimize(validate_per_element(stream));
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<std::int64_t>(data.size()));
+}
+
+void run_validated(benchmark::State& state, std::string_view sample) {
+  auto data = get_text_data(1 << 20, sample);
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto stream = make_stream(data, 4096);
+    state.ResumeTiming();
+
+    auto text = abu::feed::validate_utf8(std::ref(stream));
+    benchmark::DoNotOptimize(drain_blocks(text));
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<std::int64_t>(data.size()));
+}
+
+void run_decoded(benchmark::State& state, std::string_view sample) {
+  auto data = get_text_data(1 << 20, sample);
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto stream = make_stream(data, 4096);
+    state.ResumeTiming();
+
+    auto code_points = abu::feed::decode_utf8(std::ref(stream));
+    benchmark::DoNotOptimize(drain_blocks(code_points));
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<std::int64_t>(data.size()));
+}
+}  // namespace
+
+static void BM_utf8_ascii_per_element(benchmark::State& state) {
+  run_per_element(state, ascii_sample);
+}
+BENCHMARK(BM_utf8_ascii_per_element);
+
+static void BM_utf8_ascii_validated(benchmark::State& state) {
+  run_validated(state, ascii_sample);
+}
+BENCHMARK(BM_utf8_ascii_validated);
+
+static void BM_utf8_ascii_decoded(benchmark::State& state) {
+  run_decoded(state, ascii_sample);
+}
+BENCHMARK(BM_utf8_ascii_decoded);
+
+static void BM_utf8_mixed_per_element(benchmark::State& state) {
+  run_per_element(state, mixed_sample);
+}
+BENCHMARK(BM_utf8_mixed_per_element);
+
+static void BM_utf8_mixed_validated(benchmark::State& state) {
+  run_validated(state, mixed_sample);
+}
+BENCHMARK(BM_utf8_mixed_validated);
+
+static void BM_utf8_mixed_decoded(benchmark::State& state) {
+  run_decoded(state, mixed_sample);
+}
+BENCHMARK(BM_utf8_mixed_decoded);
@@ -23,27 +23,33 @@
 #include <iterator>
 #include <ranges>
 
+#include "abu/feed/algorithm.h"
+#include "abu/feed/any_feed.h"
+#include "abu/feed/bounded_stream.h"
+#include "abu/feed/coalescing_stream.h"
+#include "abu/feed/concat.h"
+#include "abu/feed/concepts.h"
+#include "abu/feed/concurrent_stream.h"
+#include "abu/feed/decoded_feed.h"
 #include "abu/feed/forward_range_adaptor.h"
+#include "abu/feed/framing.h"
+#include "abu/feed/input_range_adaptor.h"
+#include "abu/feed/location.h"
+#include "abu/feed/node_pool.h"
+#include "abu/feed/parallel.h"
+#include "abu/feed/scheduler.h"
 #include "abu/feed/stream.h"
 #include "abu/feed/tags.h"
+#include "abu/feed/utf8.h"
 
 namespace abu {
 
-// Defines a feed.
-// usage:
-//   void process(Feed auto& data) { ... }
-template <typename T>
-concept Feed =
-    std::input_iterator<T> && std::sentinel_for<abu::feed::empty_feed_t, T> &&
-    std::sentinel_for<abu::feed::end_of_feed_t, T>;
-
-// A feed constrained to a specific value type
-// usage:
-//   void process(FeedOf<char> auto& data) { ... }
-template <typename T, typename U>
-concept FeedOf = Feed<T> && std::same_as<U, std::iter_value_t<T>>;
-
 namespace feed {
+  template <std::input_iterator I, std::sentinel_for<I> S>
+  Feed auto adapt_range(I iterator, S sentinel) {
+    return input_range_adaptor<I, S>{std::move(iterator), std::move(sentinel)};
+  }
+
   template <std::forward_iterator I, std::sentinel_for<I> S>
   constexpr Feed auto adapt_range(I iterator, S sentinel) {
     return forward_range_adaptor<I, S>{iterator, sentinel};
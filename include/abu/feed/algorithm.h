@@ -0,0 +1,336 @@
+// Copyright 2021 Francois Chabot
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ABU_FEED_ALGORITHM_H
+#define ABU_FEED_ALGORITHM_H
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <type_traits>
+
+#include "abu/feed/concepts.h"
+#include "abu/feed/debug.h"
+#include "abu/feed/lookahead.h"
+#include "abu/feed/tags.h"
+
+// Searching algorithms for contiguous feeds.
+//
+// They work one block of current_span() at a time, using memchr() to search
+// byte-sized elements and counting them eight at a time, and handle
+// delimiters that straddle chunk boundaries.
+// Only the data currently available is looked at; none of these ever wait
+// for more.
+//
+// Delimiters are passed as spans, so prefer std::string_view over string
+// literals, which would include the terminating null character.
+
+namespace abu::feed {
+
+namespace details_ {
+template <typename T>
+concept byte_like = sizeof(T) == 1 && std::is_trivially_copyable_v<T> &&
+    !std::same_as<std::remove_cv_t<T>, bool>;
+
+template <typename T>
+std::size_t find_in_(std::span<const T> data, const T& value) {
+  if constexpr (byte_like<T>) {
+    if (data.empty()) {
+      return 0;
+    }
+    auto* found = std::memchr(
+        data.data(), std::bit_cast<unsigned char>(value), data.size());
+    return found ? static_cast<std::size_t>(static_cast<const T*>(found) -
+                                            data.data())
+                 : data.size();
+  } else {
+    return static_cast<std::size_t>(
+        std::find(data.begin(), data.end(), value) - data.begin());
+  }
+}
+
+// Counts eight bytes at a time, which unlike repeated memchr() calls doesn't
+// slow down when matches are dense. Each byte of a word has its own counter,
+// and they get summed before any of them can overflow.
+template <typename T>
+std::size_t count_in_(std::span<const T> data, const T& value) {
+  if constexpr (byte_like<T>) {
+    constexpr std::uint64_t ones = 0x0101010101010101;
+    constexpr std::uint64_t low_bits = 0x7f7f7f7f7f7f7f7f;
+    const std::uint64_t pattern = ones * std::bit_cast<std::uint8_t>(value);
+
+    const auto* bytes = reinterpret_cast<const unsigned char*>(data.data());
+    const auto n = data.size();
+
+    std::size_t result = 0;
+    std::size_t i = 0;
+    while (n - i >= 8) {
+      auto words = std::min<std::size_t>((n - i) / 8, 255);
+      std::uint64_t counters = 0;
+      for (auto end = i + words * 8; i < end; i += 8) {
+        std::uint64_t word;
+        std::memcpy(&word, bytes + i, sizeof(word));
+        word ^= pattern;
+
+        // The high bit of each byte ends up set if that byte is not zero.
+        auto non_zero = ((word & low_bits) + low_bits) | word;
+        counters += (~non_zero >> 7) & ones;
+      }
+
+      // Pairs of lanes add up to at most 510, which fits in 16 bits.
+      constexpr std::uint64_t even_lanes = 0x00ff00ff00ff00ff;
+      auto pairs = (counters & even_lanes) + ((counters >> 8) & even_lanes);
+      result += (pairs * 0x0001000100010001) >> 48;
+    }
+
+    for (; i < n; ++i) {
+      result += static_cast<std::size_t>(data[i] == value);
+    }
+    return result;
+  } else {
+    return static_cast<std::size_t>(
+        std::count(data.begin(), data.end(), value));
+  }
+}
+
+// Compares the upcoming elements of the feed with expected, without moving
+// the feed.
+template <ContiguousFeed F>
+match_status match_(F& f, std::span<const std::iter_value_t<F>> expected) {
+  auto data = f.current_span();
+  if (data.size() >= expected.size()) {
+    return std::equal(expected.begin(), expected.end(), data.begin())
+               ? match_status::match
+               : match_status::mismatch;
+  }
+
+  // expected straddles the end of the current chunk.
+  auto cp = f.checkpoint();
+  auto result = match_status::need_more;
+  while (!data.empty()) {
+    auto n = std::min(data.size(), expected.size());
+    if (!std::ranges::equal(data.first(n), expected.first(n))) {
+      result = match_status::mismatch;
+      break;
+    }
+
+    expected = expected.subspan(n);
+    if (expected.empty()) {
+      result = match_status::match;
+      break;
+    }
+
+    f.advance(static_cast<std::iter_difference_t<F>>(n));
+    data = f.current_span();
+  }
+  f.rollback(std::move(cp));
+  return result;
+}
+
+template <ContiguousFeed F>
+bool skip_until_(F& f,
+                 const std::iter_value_t<F>& value,
+                 std::iter_difference_t<F>& skipped) {
+  while (f != empty) {
+    auto data = f.current_span();
+    auto pos = find_in_(data, value);
+    auto n = static_cast<std::iter_difference_t<F>>(pos);
+
+    f.advance(n);
+    skipped += n;
+    if (pos != data.size()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+template <ContiguousFeed F>
+bool skip_until_(F& f,
+                 std::span<const std::iter_value_t<F>> delim,
+                 std::iter_difference_t<F>& skipped) {
+  precondition(!delim.empty());
+
+  while (skip_until_(f, delim.front(), skipped)) {
+    switch (match_(f, delim)) {
+      case match_status::match:
+        return true;
+      case match_status::need_more:
+        return false;
+      case match_status::mismatch:
+        f.advance(1);
+        ++skipped;
+        break;
+    }
+  }
+  return false;
+}
+}  // namespace details_
+
+// Looks at the next n elements without moving the feed.
+//
+// Streams do this by looking directly at their chunks. Other feeds are
+// walked with a checkpoint.
+template <std::size_t MaxN = default_max_peek, ContiguousFeed F>
+peek_result<std::iter_value_t<F>, MaxN> peek(F& f, std::size_t n) {
+  using value_type = std::iter_value_t<F>;
+
+  if constexpr (requires { f.template peek<MaxN>(n); }) {
+    return f.template peek<MaxN>(n);
+  } else {
+    precondition(n <= MaxN);
+
+    auto here = f.current_span();
+    if (here.size() >= n) {
+      return peek_result<value_type, MaxN>::viewing(peek_status::ok,
+                                                     here.first(n));
+    }
+
+    std::array<value_type, MaxN> buffer;
+    std::size_t count = 0;
+    auto cp = f.checkpoint();
+    while (count < n && f != empty) {
+      auto data = f.current_span();
+      auto len = std::min(n - count, data.size());
+      std::ranges::copy(data.first(len), buffer.begin() + count);
+      f.advance(static_cast<std::iter_difference_t<F>>(len));
+      count += len;
+    }
+
+    auto status = peek_status::ok;
+    if (count < n) {
+      status = f == end_of_feed ? peek_status::finished
+                                : peek_status::need_more;
+    }
+    f.rollback(std::move(cp));
+    return peek_result<value_type, MaxN>::copying(
+        status, std::span{buffer}.first(count));
+  }
+}
+
+// Checks whether the upcoming elements are prefix, without moving the feed.
+template <ContiguousFeed F>
+match_status matches(F& f, std::span<const std::iter_value_t<F>> prefix) {
+  if constexpr (requires { f.matches(prefix); }) {
+    return f.matches(prefix);
+  } else {
+    auto result = details_::match_(f, prefix);
+    if (result == match_status::need_more) {
+      // Whatever is left is shorter than prefix.
+      auto cp = f.checkpoint();
+      while (f != empty) {
+        f.advance(std::ssize(f.current_span()));
+      }
+      if (f == end_of_feed) {
+        result = match_status::mismatch;
+      }
+      f.rollback(std::move(cp));
+    }
+    return result;
+  }
+}
+
+// Moves the feed to the next occurrence of value.
+// Returns false if the feed ran out of data first, leaving it empty.
+template <ContiguousFeed F>
+bool skip_until(F& f, const std::iter_value_t<F>& value) {
+  std::iter_difference_t<F> skipped = 0;
+  return details_::skip_until_(f, value, skipped);
+}
+
+// Moves the feed to the start of the next occurrence of delim.
+// Returns false if the feed ran out of data first. In that case, the feed is
+// left where delim could still start once more data comes in, so that the
+// search can be resumed.
+template <ContiguousFeed F>
+bool skip_until(F& f, std::span<const std::iter_value_t<F>> delim) {
+  std::iter_difference_t<F> skipped = 0;
+  return details_::skip_until_(f, delim, skipped);
+}
+
+// Returns how far ahead the next occurrence of value is, without moving the
+// feed.
+template <ContiguousFeed F>
+std::optional<std::iter_difference_t<F>> find(
+    F& f,
+    const std::iter_value_t<F>& value) {
+  auto cp = f.checkpoint();
+  std::iter_difference_t<F> skipped = 0;
+  bool found = details_::skip_until_(f, value, skipped);
+  f.rollback(std::move(cp));
+
+  if (found) {
+    return skipped;
+  }
+  return std::nullopt;
+}
+
+// Returns how far ahead the next occurrence of delim is, without moving the
+// feed.
+template <ContiguousFeed F>
+std::optional<std::iter_difference_t<F>> find(
+    F& f,
+    std::span<const std::iter_value_t<F>> delim) {
+  auto cp = f.checkpoint();
+  std::iter_difference_t<F> skipped = 0;
+  bool found = details_::skip_until_(f, delim, skipped);
+  f.rollback(std::move(cp));
+
+  if (found) {
+    return skipped;
+  }
+  return std::nullopt;
+}
+
+// Counts the occurrences of value in the available data, without moving the
+// feed.
+template <ContiguousFeed F>
+std::iter_difference_t<F> count(F& f, const std::iter_value_t<F>& value) {
+  auto cp = f.checkpoint();
+  std::iter_difference_t<F> result = 0;
+  while (f != empty) {
+    auto data = f.current_span();
+    auto n = details_::count_in_(data, value);
+    result += static_cast<std::iter_difference_t<F>>(n);
+    f.advance(std::ssize(data));
+  }
+  f.rollback(std::move(cp));
+  return result;
+}
+
+// Counts the non-overlapping occurrences of delim in the available data,
+// without moving the feed.
+template <ContiguousFeed F>
+std::iter_difference_t<F> count(F& f,
+                                std::span<const std::iter_value_t<F>> delim) {
+  auto cp = f.checkpoint();
+  std::iter_difference_t<F> result = 0;
+  std::iter_difference_t<F> skipped = 0;
+  while (details_::skip_until_(f, delim, skipped)) {
+    ++result;
+    f.advance(std::ssize(delim));
+  }
+  f.rollback(std::move(cp));
+  return result;
+}
+
+}  // namespace abu::feed
+
+#endif
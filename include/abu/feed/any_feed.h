@@ -0,0 +1,445 @@
+// Copyright 2021 Francois Chabot
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ABU_FEED_ANY_FEED_H
+#define ABU_FEED_ANY_FEED_H
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "abu/feed/concepts.h"
+#include "abu/feed/debug.h"
+#include "abu/feed/tags.h"
+
+namespace abu::feed {
+
+namespace details_ {
+struct any_checkpoint_base {
+  virtual ~any_checkpoint_base() = default;
+  virtual any_checkpoint_base* clone() const = 0;
+
+  // Constructs a copy of this, or moves this, into storage that the holder
+  // is known to fit in.
+  virtual any_checkpoint_base* copy_to(void* storage) const = 0;
+  virtual any_checkpoint_base* move_to(void* storage) noexcept = 0;
+};
+
+template <typename CheckpointT>
+struct any_checkpoint_holder final : any_checkpoint_base {
+  any_checkpoint_holder(const void* in_owner, CheckpointT in_cp)
+      : owner(in_owner), cp(std::move(in_cp)) {}
+
+  any_checkpoint_base* clone() const override {
+    return new any_checkpoint_holder(*this);
+  }
+
+  any_checkpoint_base* copy_to(void* storage) const override {
+    return ::new (storage) any_checkpoint_holder(*this);
+  }
+
+  any_checkpoint_base* move_to(void* storage) noexcept override {
+    if constexpr (std::is_nothrow_move_constructible_v<CheckpointT>) {
+      return ::new (storage) any_checkpoint_holder(std::move(*this));
+    } else {
+      // Never stored inline.
+      assume(false);
+      return nullptr;
+    }
+  }
+
+  // Identifies the feed the checkpoint was taken from.
+  const void* owner;
+  CheckpointT cp;
+};
+
+// Holders that are small enough are stored in the checkpoint itself, so that
+// taking a checkpoint of the common feeds does not allocate.
+class any_checkpoint {
+  static constexpr std::size_t inline_size = 6 * sizeof(void*);
+
+  template <typename HolderT>
+  static constexpr bool fits_inline =
+      sizeof(HolderT) <= inline_size &&
+      alignof(HolderT) <= alignof(std::max_align_t) &&
+      std::is_nothrow_move_constructible_v<HolderT>;
+
+ public:
+  template <typename CheckpointT>
+  any_checkpoint(const void* owner, CheckpointT cp) {
+    using holder_type = any_checkpoint_holder<CheckpointT>;
+
+    if constexpr (fits_inline<holder_type>) {
+      impl_ = ::new (storage_) holder_type(owner, std::move(cp));
+      is_inline_ = true;
+    } else {
+      impl_ = new holder_type(owner, std::move(cp));
+    }
+  }
+
+  any_checkpoint(const any_checkpoint& other) {
+    copy_from_(other);
+  }
+
+  any_checkpoint(any_checkpoint&& other) noexcept {
+    move_from_(std::move(other));
+  }
+
+  any_checkpoint& operator=(const any_checkpoint& other) {
+    if (this != &other) {
+      reset_();
+      copy_from_(other);
+    }
+    return *this;
+  }
+
+  any_checkpoint& operator=(any_checkpoint&& other) noexcept {
+    if (this != &other) {
+      reset_();
+      move_from_(std::move(other));
+    }
+    return *this;
+  }
+
+  ~any_checkpoint() {
+    reset_();
+  }
+
+  template <typename CheckpointT>
+  CheckpointT& get(const void* owner) {
+    precondition(impl_ != nullptr, "Using checkpoint that was moved");
+
+    auto& holder = static_cast<any_checkpoint_holder<CheckpointT>&>(*impl_);
+    precondition(holder.owner == owner,
+                 "Rolling back to a checkpoint from another feed");
+    return holder.cp;
+  }
+
+ private:
+  void copy_from_(const any_checkpoint& other) {
+    precondition(other.impl_ != nullptr, "Using checkpoint that was moved");
+
+    if (other.is_inline_) {
+      impl_ = other.impl_->copy_to(storage_);
+    } else {
+      impl_ = other.impl_->clone();
+    }
+    is_inline_ = other.is_inline_;
+  }
+
+  void move_from_(any_checkpoint&& other) noexcept {
+    if (other.is_inline_) {
+      impl_ = other.impl_->move_to(storage_);
+      is_inline_ = true;
+      other.reset_();
+    } else {
+      impl_ = std::exchange(other.impl_, nullptr);
+    }
+  }
+
+  void reset_() noexcept {
+    if (is_inline_) {
+      impl_->~any_checkpoint_base();
+    } else {
+      delete impl_;
+    }
+    impl_ = nullptr;
+    is_inline_ = false;
+  }
+
+  any_checkpoint_base* impl_ = nullptr;
+  bool is_inline_ = false;
+  alignas(std::max_align_t) std::byte storage_[inline_size];
+};
+
+// What any_feed needs from the feed it wraps. Everything goes through
+// current_span() and advance(), so that virtual calls happen once per block
+// of data rather than once per element.
+template <typename T>
+struct any_feed_interface {
+  virtual ~any_feed_interface() = default;
+
+  // Must only be empty when the feed is.
+  virtual std::span<const T> current_span() = 0;
+  virtual void advance(std::ptrdiff_t n) = 0;
+  virtual bool is_end_of_feed() = 0;
+  virtual any_checkpoint checkpoint() = 0;
+  virtual void rollback(any_checkpoint cp) = 0;
+};
+
+template <typename F>
+using checkpoint_t = decltype(std::declval<F&>().checkpoint());
+
+// F is either a feed, or a reference to one.
+template <typename T, typename F>
+class contiguous_feed_model final : public any_feed_interface<T> {
+ public:
+  template <typename U>
+  explicit contiguous_feed_model(U&& feed) : feed_(std::forward<U>(feed)) {}
+
+  std::span<const T> current_span() override {
+    return feed_.current_span();
+  }
+
+  void advance(std::ptrdiff_t n) override {
+    feed_.advance(static_cast<std::iter_difference_t<feed_type>>(n));
+  }
+
+  bool is_end_of_feed() override {
+    return feed_ == end_of_feed;
+  }
+
+  any_checkpoint checkpoint() override {
+    return any_checkpoint{this, feed_.checkpoint()};
+  }
+
+  void rollback(any_checkpoint cp) override {
+    feed_.rollback(std::move(cp.get<checkpoint_type>(this)));
+  }
+
+ private:
+  using feed_type = std::remove_reference_t<F>;
+  using checkpoint_type = checkpoint_t<feed_type>;
+
+  F feed_;
+};
+
+// Feeds that can't hand out spans are read into a buffer, batch_size
+// elements at a time. A checkpoint of the wrapped feed is kept at the start
+// of the buffer so that rollbacks can refill it.
+template <typename T, typename F>
+class buffered_feed_model final : public any_feed_interface<T> {
+ public:
+  template <typename U>
+  buffered_feed_model(U&& feed, std::size_t batch_size)
+      : feed_(std::forward<U>(feed)), batch_size_(batch_size) {
+    precondition(batch_size > 0);
+    buffer_.reserve(batch_size);
+  }
+
+  std::span<const T> current_span() override {
+    if (offset_ == buffer_.size()) {
+      refill_();
+    }
+    return std::span<const T>{buffer_}.subspan(offset_);
+  }
+
+  void advance(std::ptrdiff_t n) override {
+    precondition(static_cast<std::size_t>(n) <= buffer_.size() - offset_,
+                 "advancing past the available data");
+    offset_ += static_cast<std::size_t>(n);
+  }
+
+  bool is_end_of_feed() override {
+    return offset_ == buffer_.size() && feed_ == end_of_feed;
+  }
+
+  any_checkpoint checkpoint() override {
+    // any_feed fetches the first batch as soon as it's constructed.
+    assume(batch_start_.has_value());
+    return any_checkpoint{this, checkpoint_type{*batch_start_, offset_}};
+  }
+
+  void rollback(any_checkpoint cp) override {
+    auto& [start, offset] = cp.get<checkpoint_type>(this);
+
+    feed_.rollback(start);
+    refill_();
+    assume(offset <= buffer_.size());
+    offset_ = offset;
+  }
+
+ private:
+  using feed_type = std::remove_reference_t<F>;
+  using checkpoint_type = std::pair<checkpoint_t<feed_type>, std::size_t>;
+
+  void refill_() {
+    batch_start_ = feed_.checkpoint();
+    buffer_.clear();
+    offset_ = 0;
+    while (buffer_.size() < batch_size_ && feed_ != empty) {
+      buffer_.push_back(*feed_);
+      ++feed_;
+    }
+  }
+
+  F feed_;
+  std::size_t batch_size_;
+  std::optional<checkpoint_t<feed_type>> batch_start_;
+  std::vector<T> buffer_;
+  std::size_t offset_ = 0;
+};
+}  // namespace details_
+
+// A type-erased feed of T.
+//
+// usage:
+//   abu::feed::any_feed<char> data{std::move(some_feed)};
+//   abu::feed::any_feed<char> view{std::ref(some_stream)};
+//
+// The wrapped feed is accessed one block at a time, and the block is then
+// read locally, so that the type erasure costs next to nothing per element.
+// Feeds that are not contiguous are copied into a buffer of batch_size
+// elements, which requires their checkpoints to be copyable.
+//
+// Passing a std::reference_wrapper wraps the feed without taking ownership of
+// it, which lets a producer keep appending to a stream behind an any_feed.
+template <typename T>
+class any_feed {
+ public:
+  static constexpr std::size_t default_batch_size = 256;
+
+  using checkpoint_type = details_::any_checkpoint;
+
+  using iterator_tag = std::input_iterator_tag;
+  using difference_type = std::ptrdiff_t;
+  using value_type = T;
+
+  template <typename F>
+  requires(!std::same_as<std::remove_cvref_t<F>, any_feed>) &&
+      FeedOf<std::remove_reference_t<details_::stored_feed_t<F>>, T>
+  explicit any_feed(F&& feed, std::size_t batch_size = default_batch_size) {
+    using stored_type = details_::stored_feed_t<F>;
+    using feed_type = std::remove_reference_t<stored_type>;
+
+    if constexpr (ContiguousFeed<feed_type>) {
+      impl_ =
+          std::make_unique<details_::contiguous_feed_model<T, stored_type>>(
+              std::forward<F>(feed));
+    } else {
+      impl_ = std::make_unique<details_::buffered_feed_model<T, stored_type>>(
+          std::forward<F>(feed), batch_size);
+    }
+    next_block_();
+  }
+
+  any_feed(any_feed&&) = default;
+  any_feed& operator=(any_feed&&) = default;
+
+  const T& operator*() const {
+    if (pos_ == end_) {
+      // Data might have shown up since we last looked.
+      next_block_();
+    }
+    precondition(pos_ != end_);
+    return *pos_;
+  }
+
+  any_feed& operator++() {
+    if (pos_ == end_) {
+      next_block_();
+    }
+    precondition(pos_ != end_);
+
+    ++pos_;
+    if (pos_ == end_) {
+      next_block_();
+    }
+    return *this;
+  }
+
+  void operator++(int) {
+    ++(*this);
+  }
+
+  bool operator==(const empty_feed_t&) const {
+    precondition(impl_ != nullptr, moved_err_msg);
+    if (pos_ == end_) {
+      next_block_();
+    }
+    return pos_ == end_;
+  }
+
+  bool operator==(const end_of_feed_t&) const {
+    return *this == empty && impl_->is_end_of_feed();
+  }
+
+  // Returns the unread remainder of the current block.
+  std::span<const T> current_span() const {
+    precondition(impl_ != nullptr, moved_err_msg);
+    if (pos_ == end_) {
+      next_block_();
+    }
+    return {pos_, end_};
+  }
+
+  // Skips n elements, which must all be currently available.
+  void advance(difference_type n) {
+    precondition(n >= 0);
+
+    while (n > 0) {
+      auto block = current_span();
+      precondition(!block.empty(), "advancing past the available data");
+
+      auto step = std::min(n, std::ssize(block));
+      pos_ += step;
+      n -= step;
+    }
+
+    if (pos_ == end_) {
+      next_block_();
+    }
+  }
+
+  checkpoint_type checkpoint() {
+    precondition(impl_ != nullptr, moved_err_msg);
+    sync_();
+    return impl_->checkpoint();
+  }
+
+  void rollback(checkpoint_type cp) {
+    precondition(impl_ != nullptr, moved_err_msg);
+    impl_->rollback(std::move(cp));
+    block_begin_ = pos_ = end_ = nullptr;
+    next_block_();
+  }
+
+ private:
+  static constexpr const char* moved_err_msg = "Using any_feed that was moved";
+
+  // Lets the wrapped feed know about what has been read locally.
+  void sync_() const {
+    if (pos_ != block_begin_) {
+      impl_->advance(pos_ - block_begin_);
+      block_begin_ = pos_;
+    }
+  }
+
+  void next_block_() const {
+    sync_();
+    auto block = impl_->current_span();
+    block_begin_ = pos_ = block.data();
+    end_ = block.data() + block.size();
+  }
+
+  std::unique_ptr<details_::any_feed_interface<T>> impl_;
+
+  // The block currently being read. Fetching the next one is not observable
+  // from the feed interface, so it's allowed in const members.
+  mutable const T* block_begin_ = nullptr;
+  mutable const T* pos_ = nullptr;
+  mutable const T* end_ = nullptr;
+};
+
+}  // namespace abu::feed
+
+#endif
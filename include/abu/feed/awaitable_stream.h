@@ -0,0 +1,181 @@
+// Copyright 2021 Francois Chabot
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ABU_FEED_AWAITABLE_STREAM_H
+#define ABU_FEED_AWAITABLE_STREAM_H
+
+#include <concepts>
+#include <coroutine>
+#include <memory>
+#include <utility>
+
+#include "abu/feed/debug.h"
+#include "abu/feed/stream.h"
+#include "abu/feed/tags.h"
+
+namespace abu::feed {
+
+// Decides where a consumer suspended on an awaitable_stream gets resumed.
+template <typename T>
+concept CoroutineExecutor =
+    requires(T& executor, std::coroutine_handle<> handle) {
+  executor.execute(handle);
+};
+
+// Resumes the consumer from within append()/finish().
+struct inline_executor {
+  void execute(std::coroutine_handle<> handle) const {
+    handle.resume();
+  }
+};
+
+// A stream that a coroutine can co_await when it runs out of data.
+//
+// usage:
+//   task consume(awaitable_stream<std::string>& data) {
+//     while (true) {
+//       co_await data;
+//       if (data == abu::feed::end_of_feed) {
+//         co_return;
+//       }
+//       while (data != abu::feed::empty) { ... }
+//     }
+//   }
+//
+// append() and finish() hand the suspended consumer, if any, to the
+// executor as soon as there is something for it to look at. The stream is
+// privately based on stream, so that nothing can be appended through a path
+// that doesn't wake the consumer.
+template <Chunk ChunkT,
+          CoroutineExecutor Executor = inline_executor,
+          typename Alloc = std::allocator<ChunkT>>
+class awaitable_stream : private stream<ChunkT, Alloc> {
+  using base_type = stream<ChunkT, Alloc>;
+
+ public:
+  using executor_type = Executor;
+
+  using typename base_type::allocator_type;
+  using typename base_type::checkpoint_type;
+  using typename base_type::chunk_type;
+  using typename base_type::cursor_type;
+  using typename base_type::difference_type;
+  using typename base_type::iterator_tag;
+  using typename base_type::node_type;
+  using typename base_type::rope_type;
+  using typename base_type::scoped_checkpoint_type;
+  using typename base_type::value_type;
+
+  awaitable_stream() = default;
+
+  explicit awaitable_stream(Executor executor, const Alloc& alloc = Alloc())
+      : base_type(alloc), executor_(std::move(executor)) {}
+
+  // A suspended consumer goes along with the stream.
+  awaitable_stream(awaitable_stream&& other)
+      : base_type(std::move(other)),
+        waiter_(std::exchange(other.waiter_, {})),
+        executor_(std::move(other.executor_)) {}
+
+  awaitable_stream& operator=(awaitable_stream&& other) {
+    precondition(!waiter_, "overwriting a stream a consumer is waiting on");
+    base_type::operator=(std::move(other));
+    waiter_ = std::exchange(other.waiter_, {});
+    executor_ = std::move(other.executor_);
+    return *this;
+  }
+
+  using base_type::operator*;
+  using base_type::operator==;
+
+  awaitable_stream& operator++() {
+    base_type::operator++();
+    return *this;
+  }
+
+  void operator++(int) {
+    ++(*this);
+  }
+
+  using base_type::advance;
+  using base_type::checkpoint;
+  using base_type::current_location;
+  using base_type::current_span;
+  using base_type::cursor;
+  using base_type::distance;
+  using base_type::get_allocator;
+  using base_type::location_of;
+  using base_type::matches;
+  using base_type::offset;
+  using base_type::offset_of;
+  using base_type::peek;
+  using base_type::retain;
+  using base_type::rollback;
+  using base_type::rope;
+  using base_type::scoped_checkpoint;
+  using base_type::slice;
+  using base_type::stats;
+  using base_type::track_lines;
+
+  void append(ChunkT&& chunk) {
+    base_type::append(std::move(chunk));
+
+    if (*this != empty) {
+      wake_();
+    }
+  }
+
+  void finish() {
+    base_type::finish();
+    wake_();
+  }
+
+  // Suspends until the stream is not empty anymore, or has reached its end.
+  auto operator co_await() {
+    struct awaiter {
+      awaitable_stream& self;
+
+      bool await_ready() const {
+        return self != empty || self == end_of_feed;
+      }
+
+      void await_suspend(std::coroutine_handle<> handle) {
+        precondition(!self.waiter_, "only one consumer can wait on a stream");
+        self.waiter_ = handle;
+      }
+
+      void await_resume() const {}
+    };
+
+    return awaiter{*this};
+  }
+
+  Executor& executor() {
+    return executor_;
+  }
+
+ private:
+  void wake_() {
+    if (waiter_) {
+      executor_.execute(std::exchange(waiter_, {}));
+    }
+  }
+
+  std::coroutine_handle<> waiter_;
+  [[no_unique_address]] Executor executor_;
+};
+
+}  // namespace abu::feed
+
+#endif
@@ -0,0 +1,136 @@
+// Copyright 2021 Francois Chabot
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ABU_FEED_BOUNDED_STREAM_H
+#define ABU_FEED_BOUNDED_STREAM_H
+
+#include <cstddef>
+#include <memory>
+#include <ranges>
+#include <utility>
+
+#include "abu/feed/debug.h"
+#include "abu/feed/stream.h"
+#include "abu/mem.h"
+
+namespace abu::feed {
+
+namespace details_ {
+struct budget_state {
+  std::size_t budget;
+  std::size_t retained = 0;
+};
+
+// A chunk that counts itself against a budget for as long as it's alive.
+template <Chunk ChunkT>
+class budgeted_chunk {
+ public:
+  budgeted_chunk(ChunkT&& chunk, mem::ref_count_ptr<budget_state> state)
+      : chunk_(std::move(chunk)),
+        size_(static_cast<std::size_t>(std::ranges::distance(chunk_))),
+        state_(std::move(state)) {
+    state_->retained += size_;
+  }
+
+  budgeted_chunk(budgeted_chunk&& other)
+      : chunk_(std::move(other.chunk_)),
+        size_(other.size_),
+        state_(std::exchange(other.state_, nullptr)) {}
+
+  budgeted_chunk& operator=(budgeted_chunk&&) = delete;
+
+  ~budgeted_chunk() {
+    if (state_ != nullptr) {
+      state_->retained -= size_;
+    }
+  }
+
+  auto begin() const {
+    return std::ranges::begin(chunk_);
+  }
+
+  auto end() const {
+    return std::ranges::end(chunk_);
+  }
+
+ private:
+  ChunkT chunk_;
+  std::size_t size_;
+  mem::ref_count_ptr<budget_state> state_;
+};
+}  // namespace details_
+
+enum class budget_status { within, exceeded };
+
+// A stream that keeps track of how many elements it retains, including the
+// ones only kept alive by checkpoints, against a budget.
+//
+// usage:
+//   abu::feed::bounded_stream<std::vector<char>> data{1 << 20};
+//
+//   while (data.headroom() > 0 && socket.readable()) {
+//     data.append(socket.read(data.headroom()));
+//   }
+//
+// Chunks are never refused: append() reports when the budget is exceeded,
+// and it's up to the producer to stop producing until headroom() is back.
+template <Chunk ChunkT, typename Alloc = std::allocator<ChunkT>>
+class bounded_stream : public stream<details_::budgeted_chunk<ChunkT>, Alloc> {
+  using base_type = stream<details_::budgeted_chunk<ChunkT>, Alloc>;
+  using budgeted_type = details_::budgeted_chunk<ChunkT>;
+
+ public:
+  explicit bounded_stream(std::size_t budget, const Alloc& alloc = Alloc())
+      : base_type(alloc),
+        state_(mem::make_ref_counted<details_::budget_state>(budget)) {}
+
+  bounded_stream& operator++() {
+    base_type::operator++();
+    return *this;
+  }
+
+  void operator++(int) {
+    ++(*this);
+  }
+
+  budget_status append(ChunkT&& chunk) {
+    base_type::append(budgeted_type{std::move(chunk), state_});
+    return retained() > budget() ? budget_status::exceeded
+                                 : budget_status::within;
+  }
+
+  std::size_t budget() const {
+    precondition(state_ != nullptr, "Using stream feed that was moved");
+    return state_->budget;
+  }
+
+  // Number of elements currently held by the stream and its checkpoints.
+  std::size_t retained() const {
+    precondition(state_ != nullptr, "Using stream feed that was moved");
+    return state_->retained;
+  }
+
+  // How many more elements can be appended before exceeding the budget.
+  std::size_t headroom() const {
+    auto used = retained();
+    return used < budget() ? budget() - used : 0;
+  }
+
+ private:
+  mem::ref_count_ptr<details_::budget_state> state_;
+};
+
+}  // namespace abu::feed
+
+#endif
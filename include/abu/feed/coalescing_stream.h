@@ -0,0 +1,284 @@
+// Copyright 2021 Francois Chabot
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ABU_FEED_COALESCING_STREAM_H
+#define ABU_FEED_COALESCING_STREAM_H
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+#include "abu/feed/debug.h"
+#include "abu/feed/stream.h"
+
+namespace abu::feed {
+
+namespace details_ {
+// Fixed-capacity storage that small chunks get copied into. Its size can
+// grow through a const coalesced_chunk, but its storage never moves.
+template <typename T>
+struct coalesce_block {
+  explicit coalesce_block(std::size_t cap)
+      : capacity(cap), data(std::make_unique_for_overwrite<T[]>(cap)) {}
+
+  std::size_t room() const {
+    return capacity - size;
+  }
+
+  void push(std::span<const T> values) {
+    assume(values.size() <= room());
+    std::ranges::copy(values, data.get() + size);
+    size += values.size();
+  }
+
+  // The storage past size, which can be written to directly.
+  std::span<T> unused() const {
+    return {data.get() + size, room()};
+  }
+
+  void commit(std::size_t n) {
+    assume(n <= room());
+    size += n;
+  }
+
+  std::size_t size = 0;
+  std::size_t capacity;
+  std::unique_ptr<T[]> data;
+};
+
+// Either a chunk as it was appended, or a block of coalesced small chunks.
+template <std::ranges::contiguous_range ChunkT>
+class coalesced_chunk {
+ public:
+  using value_type = std::ranges::range_value_t<ChunkT>;
+  using block_type = coalesce_block<value_type>;
+
+  explicit coalesced_chunk(ChunkT&& chunk) : chunk_(std::move(chunk)) {}
+  explicit coalesced_chunk(std::unique_ptr<block_type> block)
+      : block_(std::move(block)) {}
+
+  const value_type* begin() const {
+    return block_ ? block_->data.get() : std::ranges::data(*chunk_);
+  }
+
+  const value_type* end() const {
+    return begin() + (block_ ? block_->size : std::ranges::size(*chunk_));
+  }
+
+  block_type* block() const {
+    return block_.get();
+  }
+
+ private:
+  std::optional<ChunkT> chunk_;
+  std::unique_ptr<block_type> block_;
+};
+}  // namespace details_
+
+// A stream that copies small chunks next to each other instead of giving
+// each of them its own node.
+//
+// Chunks smaller than threshold are copied into the block at the tail of the
+// stream, as long as it has room for them, and become readable right away.
+// Blocks have a fixed capacity, so iterators and checkpoints into them stay
+// valid as they fill up. Larger chunks are kept as they are.
+//
+// Producers can also write straight into the blocks with prepare() and
+// commit(), which saves them from building chunks of their own. The stream
+// is privately based on stream, so that nothing can be appended behind the
+// back of the open block.
+template <std::ranges::contiguous_range ChunkT,
+          typename Alloc = std::allocator<ChunkT>>
+requires std::is_trivially_copyable_v<std::ranges::range_value_t<ChunkT>>
+class coalescing_stream
+    : private stream<details_::coalesced_chunk<ChunkT>, Alloc> {
+  using base_type = stream<details_::coalesced_chunk<ChunkT>, Alloc>;
+  using coalesced_type = details_::coalesced_chunk<ChunkT>;
+  using block_type = typename coalesced_type::block_type;
+
+ public:
+  using typename base_type::allocator_type;
+  using typename base_type::checkpoint_type;
+  using typename base_type::chunk_type;
+  using typename base_type::cursor_type;
+  using typename base_type::difference_type;
+  using typename base_type::iterator_tag;
+  using typename base_type::node_type;
+  using typename base_type::rope_type;
+  using typename base_type::scoped_checkpoint_type;
+  using typename base_type::value_type;
+
+  static constexpr std::size_t default_threshold = 256;
+  static constexpr std::size_t default_block_size = 4096;
+
+  explicit coalescing_stream(std::size_t threshold = default_threshold,
+                             std::size_t block_size = default_block_size,
+                             const Alloc& alloc = Alloc())
+      : base_type(alloc), threshold_(threshold), block_size_(block_size) {
+    precondition(threshold <= block_size);
+  }
+
+  coalescing_stream(coalescing_stream&& other)
+      : base_type(std::move(other)),
+        threshold_(other.threshold_),
+        block_size_(other.block_size_),
+        open_block_(std::exchange(other.open_block_, nullptr)),
+        spare_block_(std::move(other.spare_block_)),
+        prepared_(std::exchange(other.prepared_, nullptr)) {}
+
+  coalescing_stream& operator=(coalescing_stream&& other) {
+    base_type::operator=(std::move(other));
+    threshold_ = other.threshold_;
+    block_size_ = other.block_size_;
+    open_block_ = std::exchange(other.open_block_, nullptr);
+    spare_block_ = std::move(other.spare_block_);
+    prepared_ = std::exchange(other.prepared_, nullptr);
+    return *this;
+  }
+
+  using base_type::operator*;
+  using base_type::operator==;
+
+  coalescing_stream& operator++() {
+    base_type::operator++();
+    return *this;
+  }
+
+  void operator++(int) {
+    ++(*this);
+  }
+
+  using base_type::advance;
+  using base_type::checkpoint;
+  using base_type::current_location;
+  using base_type::current_span;
+  using base_type::cursor;
+  using base_type::distance;
+  using base_type::get_allocator;
+  using base_type::location_of;
+  using base_type::matches;
+  using base_type::offset;
+  using base_type::offset_of;
+  using base_type::peek;
+  using base_type::retain;
+  using base_type::rollback;
+  using base_type::rope;
+  using base_type::scoped_checkpoint;
+  using base_type::slice;
+  using base_type::stats;
+  using base_type::track_lines;
+
+  void append(ChunkT&& chunk) {
+    prepared_ = nullptr;
+    auto size = std::ranges::size(chunk);
+    if (size < threshold_) {
+      append_copy(chunk);
+      return;
+    }
+
+    open_block_ = nullptr;
+    base_type::append(coalesced_type{std::move(chunk)});
+  }
+
+  // Copies data into the stream.
+  void append_copy(std::span<const value_type> data) {
+    prepared_ = nullptr;
+    if (data.empty()) {
+      return;
+    }
+
+    if (open_block_ && open_block_->room() >= data.size()) {
+      open_block_->push(data);
+      this->tail_grew_();
+      return;
+    }
+
+    auto block =
+        std::make_unique<block_type>(std::max(block_size_, data.size()));
+    block->push(data);
+    open_block_ = block.get();
+    base_type::append(coalesced_type{std::move(block)});
+  }
+
+  // Returns room for at least n elements at the tail of the stream, to be
+  // written to directly and handed over with commit().
+  // usage:
+  //   auto buffer = data.prepare(4096);
+  //   auto n = recv(fd, buffer.data(), buffer.size(), 0);
+  //   data.commit(static_cast<std::size_t>(n));
+  //
+  // The room is taken from the block at the tail when it has enough left, so
+  // that commits don't cost a node each. The returned span is only valid
+  // until the next call to any of the appending functions.
+  std::span<value_type> prepare(std::size_t n) {
+    precondition(n > 0);
+
+    if (open_block_ && open_block_->room() >= n) {
+      prepared_ = open_block_;
+    } else {
+      // The block only joins the stream once something is committed to it.
+      if (!spare_block_ || spare_block_->room() < n) {
+        spare_block_ = std::make_unique<block_type>(std::max(block_size_, n));
+      }
+      prepared_ = spare_block_.get();
+    }
+    return prepared_->unused();
+  }
+
+  // Makes the first n elements of the last prepare() readable.
+  void commit(std::size_t n) {
+    precondition(prepared_ != nullptr, "committing without prepare()");
+    precondition(n <= prepared_->room(), "committing more than was prepared");
+
+    auto* block = std::exchange(prepared_, nullptr);
+    if (n == 0) {
+      return;
+    }
+
+    block->commit(n);
+    if (block == spare_block_.get()) {
+      open_block_ = block;
+      base_type::append(coalesced_type{std::move(spare_block_)});
+    } else {
+      this->tail_grew_();
+    }
+  }
+
+  void finish() {
+    open_block_ = nullptr;
+    prepared_ = nullptr;
+    spare_block_.reset();
+    base_type::finish();
+  }
+
+ private:
+  std::size_t threshold_;
+  std::size_t block_size_;
+
+  // The block at the tail of the stream, if it is one.
+  block_type* open_block_ = nullptr;
+
+  // A block handed out by prepare() that nothing was committed to yet, and
+  // the block the last prepare() handed out.
+  std::unique_ptr<block_type> spare_block_;
+  block_type* prepared_ = nullptr;
+};
+
+}  // namespace abu::feed
+
+#endif
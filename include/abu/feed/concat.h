@@ -0,0 +1,210 @@
+// Copyright 2021 Francois Chabot
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ABU_FEED_CONCAT_H
+#define ABU_FEED_CONCAT_H
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "abu/feed/concepts.h"
+#include "abu/feed/debug.h"
+#include "abu/feed/tags.h"
+
+namespace abu::feed {
+
+namespace details_ {
+template <typename F>
+using member_feed_t = std::remove_reference_t<F>;
+
+template <typename F>
+using member_checkpoint_t =
+    decltype(std::declval<member_feed_t<F>&>().checkpoint());
+
+template <typename F>
+concept checkpointable_member = requires(member_feed_t<F>& f) {
+  f.rollback(f.checkpoint());
+};
+
+template <typename... F>
+struct concat_checkpoint {
+  std::size_t active;
+  std::tuple<member_checkpoint_t<F>...> members;
+};
+}  // namespace details_
+
+// Reads a sequence of feeds, one after the other, as a single feed.
+//
+// usage:
+//   auto data = abu::feed::concat(abu::feed::adapt_range(preamble),
+//                                 std::ref(body_stream));
+//
+// Members are stored by value, unless they are passed as a
+// std::reference_wrapper. A member is only moved on from once it reaches its
+// end_of_feed, so the concatenation is empty whenever its current member is,
+// and only reaches its end_of_feed once all of them have.
+//
+// Checkpoints record the position of every member, so that rolling back to a
+// previous member also rewinds the ones that were read since.
+template <typename... F>
+requires(sizeof...(F) > 0) && (Feed<details_::member_feed_t<F>> && ...) &&
+    (std::same_as<std::iter_value_t<details_::member_feed_t<F>>,
+                  std::iter_value_t<details_::member_feed_t<
+                      std::tuple_element_t<0, std::tuple<F...>>>>> &&
+     ...)
+class concat_feed {
+  static constexpr std::size_t member_count = sizeof...(F);
+  static constexpr bool is_contiguous =
+      (ContiguousFeed<details_::member_feed_t<F>> && ...);
+
+ public:
+  using iterator_tag = std::input_iterator_tag;
+  using difference_type = std::ptrdiff_t;
+  using value_type = std::iter_value_t<
+      details_::member_feed_t<std::tuple_element_t<0, std::tuple<F...>>>>;
+  using reference = std::common_reference_t<
+      std::iter_reference_t<const details_::member_feed_t<F>>...>;
+  using checkpoint_type = details_::concat_checkpoint<F...>;
+
+  template <typename... U>
+  requires(sizeof...(U) == member_count) explicit concat_feed(U&&... members)
+      : members_(std::forward<U>(members)...) {}
+
+  reference operator*() const {
+    skip_finished_();
+    precondition(!with_active_([](const auto& m) { return m == empty; }));
+    return with_active_([](const auto& m) -> reference { return *m; });
+  }
+
+  concat_feed& operator++() {
+    skip_finished_();
+    precondition(!with_active_([](const auto& m) { return m == empty; }));
+    with_active_([](auto& m) { ++m; });
+    return *this;
+  }
+
+  void operator++(int) {
+    ++(*this);
+  }
+
+  bool operator==(const empty_feed_t&) const {
+    skip_finished_();
+    return with_active_([](const auto& m) { return m == empty; });
+  }
+
+  bool operator==(const end_of_feed_t&) const {
+    skip_finished_();
+    return with_active_([](const auto& m) { return m == end_of_feed; });
+  }
+
+  // Returns the unread remainder of the current block of the current member.
+  std::span<const value_type> current_span() const requires is_contiguous {
+    skip_finished_();
+    return with_active_(
+        [](const auto& m) -> std::span<const value_type> {
+          return m.current_span();
+        });
+  }
+
+  // Skips n elements, which must all be currently available.
+  void advance(difference_type n) requires is_contiguous {
+    precondition(n >= 0);
+
+    while (n > 0) {
+      auto block = current_span();
+      precondition(!block.empty(), "advancing past the available data");
+
+      auto step = std::min(n, std::ssize(block));
+      with_active_([&](auto& m) {
+        m.advance(static_cast<std::iter_difference_t<
+                      std::remove_reference_t<decltype(m)>>>(step));
+      });
+      n -= step;
+    }
+  }
+
+  checkpoint_type checkpoint() requires(
+      details_::checkpointable_member<F>&&...) {
+    return std::apply(
+        [&](auto&... m) {
+          return checkpoint_type{active_,
+                                 {details_::unwrap_member(m).checkpoint()...}};
+        },
+        members_);
+  }
+
+  void rollback(checkpoint_type cp) requires(
+      details_::checkpointable_member<F>&&...) {
+    rollback_members_(cp, std::index_sequence_for<F...>{});
+    active_ = cp.active;
+  }
+
+ private:
+  template <std::size_t... I>
+  void rollback_members_(checkpoint_type& cp, std::index_sequence<I...>) {
+    (details_::unwrap_member(std::get<I>(members_))
+         .rollback(std::move(std::get<I>(cp.members))),
+     ...);
+  }
+
+  // Moves on from members that are done, which is not observable from the
+  // feed interface.
+  void skip_finished_() const {
+    while (active_ + 1 < member_count &&
+           with_active_([](const auto& m) { return m == end_of_feed; })) {
+      ++active_;
+    }
+  }
+
+  template <std::size_t I = 0, typename Fn>
+  decltype(auto) with_active_(Fn&& fn) const {
+    if constexpr (I + 1 < member_count) {
+      if (active_ != I) {
+        return with_active_<I + 1>(std::forward<Fn>(fn));
+      }
+    }
+    return fn(std::as_const(details_::unwrap_member(std::get<I>(members_))));
+  }
+
+  template <std::size_t I = 0, typename Fn>
+  decltype(auto) with_active_(Fn&& fn) {
+    if constexpr (I + 1 < member_count) {
+      if (active_ != I) {
+        return with_active_<I + 1>(std::forward<Fn>(fn));
+      }
+    }
+    return fn(details_::unwrap_member(std::get<I>(members_)));
+  }
+
+  std::tuple<details_::member_storage_t<F>...> members_;
+  mutable std::size_t active_ = 0;
+};
+
+// usage:
+//   auto data = abu::feed::concat(header_feed, std::ref(body_stream));
+template <typename... F>
+requires(Feed<std::remove_reference_t<details_::stored_feed_t<F>>>&&...)
+auto concat(F&&... feeds) {
+  using result_type = concat_feed<details_::stored_feed_t<F>...>;
+  return result_type{std::forward<F>(feeds)...};
+}
+
+}  // namespace abu::feed
+
+#endif
@@ -0,0 +1,102 @@
+// Copyright 2021 Francois Chabot
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ABU_FEED_CONCEPTS_H_INCLUDED
+#define ABU_FEED_CONCEPTS_H_INCLUDED
+
+#include <concepts>
+#include <functional>
+#include <iterator>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+#include "abu/feed/tags.h"
+
+namespace abu {
+
+// Defines a feed.
+// usage:
+//   void process(Feed auto& data) { ... }
+template <typename T>
+concept Feed =
+    std::input_iterator<T> && std::sentinel_for<abu::feed::empty_feed_t, T> &&
+    std::sentinel_for<abu::feed::end_of_feed_t, T>;
+
+// A feed constrained to a specific value type
+// usage:
+//   void process(FeedOf<char> auto& data) { ... }
+template <typename T, typename U>
+concept FeedOf = Feed<T> && std::same_as<U, std::iter_value_t<T>>;
+
+// A feed that can expose its currently available data in contiguous blocks.
+// usage:
+//   void process(ContiguousFeed auto& data) {
+//     auto block = data.current_span();
+//     ...
+//     data.advance(std::ssize(block));
+//   }
+template <typename T>
+concept ContiguousFeed =
+    Feed<T> && requires(T& feed, std::iter_difference_t<T> n) {
+  {
+    std::as_const(feed).current_span()
+    } -> std::convertible_to<std::span<const std::iter_value_t<T>>>;
+  feed.advance(n);
+  feed.rollback(feed.checkpoint());
+};
+
+namespace feed::details_ {
+template <typename F>
+struct unwrap_feed {
+  using type = F;
+};
+
+template <typename F>
+struct unwrap_feed<std::reference_wrapper<F>> {
+  using type = F&;
+};
+
+// How combinators store the feeds they are given: by value, or by reference
+// when passed a std::reference_wrapper.
+template <typename F>
+using stored_feed_t = typename unwrap_feed<std::remove_cvref_t<F>>::type;
+
+// References are held as std::reference_wrapper, so that assigning a
+// combinator doesn't assign through them.
+template <typename F>
+using member_storage_t =
+    std::conditional_t<std::is_reference_v<F>,
+                       std::reference_wrapper<std::remove_reference_t<F>>,
+                       F>;
+
+template <typename T>
+inline constexpr bool is_reference_wrapper = false;
+
+template <typename T>
+inline constexpr bool is_reference_wrapper<std::reference_wrapper<T>> = true;
+
+template <typename T>
+decltype(auto) unwrap_member(T& member) {
+  if constexpr (is_reference_wrapper<std::remove_const_t<T>>) {
+    return member.get();
+  } else {
+    return member;
+  }
+}
+}  // namespace feed::details_
+
+}  // namespace abu
+
+#endif
@@ -0,0 +1,308 @@
+// Copyright 2021 Francois Chabot
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ABU_FEED_CONCURRENT_STREAM_H
+#define ABU_FEED_CONCURRENT_STREAM_H
+
+#include <atomic>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <span>
+
+#include "abu/feed/debug.h"
+#include "abu/feed/node_ptr.h"
+#include "abu/feed/stream.h"
+#include "abu/feed/tags.h"
+
+namespace abu::feed {
+
+template <Chunk ChunkT, typename Alloc = std::allocator<ChunkT>>
+class concurrent_stream;
+
+namespace details_ {
+template <Chunk ChunkT, typename Alloc>
+struct concurrent_stream_node {
+  static_assert(std::is_const_v<ChunkT>);
+
+  explicit concurrent_stream_node(const Alloc& alloc) : alloc_(alloc) {}
+  concurrent_stream_node(std::remove_const_t<ChunkT>&& in_data,
+                         const Alloc& alloc)
+      : data_(std::move(in_data)), alloc_(alloc) {}
+
+  concurrent_stream_node(const concurrent_stream_node&) = delete;
+  concurrent_stream_node& operator=(const concurrent_stream_node&) = delete;
+
+  ~concurrent_stream_node() {
+    detach_next();
+  }
+
+  std::ranges::iterator_t<ChunkT> begin() const {
+    if (data_) {
+      return std::ranges::begin(*data_);
+    }
+    return {};
+  }
+
+  std::ranges::sentinel_t<ChunkT> end() const {
+    if (data_) {
+      return std::ranges::end(*data_);
+    }
+    return {};
+  }
+
+  // Producer side: publishes the node to the consumer.
+  void mark_final() {
+    assume(!next() && !is_final());
+    is_final_.store(true, std::memory_order_release);
+  }
+
+  // Producer side: publishes the node to the consumer.
+  void set_next(node_ptr<concurrent_stream_node> next) {
+    assume(!this->next() && !is_final());
+    next_.store(next.release(), std::memory_order_release);
+  }
+
+  bool is_final() const {
+    return is_final_.load(std::memory_order_acquire);
+  }
+
+  // The returned node is kept alive by this one.
+  concurrent_stream_node* next() const {
+    return next_.load(std::memory_order_acquire);
+  }
+
+  const Alloc& get_allocator() const {
+    return alloc_;
+  }
+
+  // node_ptr interface
+  void add_ref() noexcept {
+    ref_count_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  bool release_ref() noexcept {
+    return ref_count_.fetch_sub(1, std::memory_order_acq_rel) == 1;
+  }
+
+  node_ptr<concurrent_stream_node> detach_next() noexcept {
+    return node_ptr<concurrent_stream_node>::adopt(
+        next_.exchange(nullptr, std::memory_order_acquire));
+  }
+
+  static void destroy(concurrent_stream_node* node) noexcept {
+    deallocate_node(node, node->alloc_);
+  }
+
+ private:
+  std::atomic<std::size_t> ref_count_ = 1;
+  std::atomic<concurrent_stream_node*> next_ = nullptr;
+  std::atomic<bool> is_final_ = false;
+  std::optional<ChunkT> data_;
+  [[no_unique_address]] Alloc alloc_;
+};
+
+template <Chunk ChunkT, typename Alloc>
+struct concurrent_stream_checkpoint {
+ private:
+  friend class concurrent_stream<ChunkT, Alloc>;
+
+  using node_type = concurrent_stream_node<const ChunkT, Alloc>;
+
+  concurrent_stream_checkpoint(std::ranges::iterator_t<const ChunkT> pos,
+                               node_ptr<node_type> chunk)
+      : position_(std::move(pos)), current_chunk_(std::move(chunk)) {}
+
+  std::ranges::iterator_t<const ChunkT> position_;
+  node_ptr<node_type> current_chunk_;
+};
+}  // namespace details_
+
+// A stream that can be fed by one producer thread while being consumed by
+// another one, without locking.
+//
+// - append() and finish() may only be called from the producer thread.
+// - Everything else may only be called from the consumer thread.
+// - Nodes are allocated by the producer and released by the consumer, so Alloc
+//   has to be thread-safe.
+template <Chunk ChunkT, typename Alloc>
+class concurrent_stream {
+  static constexpr const char* moved_err_msg =
+      "Using stream feed that was moved";
+
+ public:
+  using chunk_type = const ChunkT;
+  using allocator_type = Alloc;
+  using node_type = details_::concurrent_stream_node<chunk_type, Alloc>;
+  using checkpoint_type =
+      details_::concurrent_stream_checkpoint<ChunkT, Alloc>;
+
+  using iterator_tag = std::input_iterator_tag;
+  using difference_type = std::ptrdiff_t;
+  using value_type = std::ranges::range_value_t<ChunkT>;
+
+  concurrent_stream() : concurrent_stream(Alloc()) {}
+
+  explicit concurrent_stream(const Alloc& alloc) {
+    tail_ = details_::allocate_node<node_type>(alloc);
+    start_chunk_(tail_);
+  }
+
+  concurrent_stream(concurrent_stream&&) = default;
+  concurrent_stream(const concurrent_stream&) = delete;
+
+  concurrent_stream& operator=(concurrent_stream&&) = default;
+  concurrent_stream& operator=(const concurrent_stream&) = delete;
+
+  // ***** Consumer side *****
+
+  decltype(auto) operator*() const {
+    precondition(!is_moved_(), moved_err_msg);
+    catch_up_();
+    precondition(position_ != chunk_end_);
+
+    return *position_;
+  }
+
+  concurrent_stream& operator++() {
+    precondition(!is_moved_(), moved_err_msg);
+    catch_up_();
+    precondition(position_ != chunk_end_);
+
+    ++position_;
+    return *this;
+  }
+
+  void operator++(int) {
+    ++(*this);
+  }
+
+  bool operator==(const empty_feed_t&) const {
+    precondition(!is_moved_(), moved_err_msg);
+    catch_up_();
+    return position_ == chunk_end_;
+  }
+
+  bool operator==(const end_of_feed_t&) const {
+    precondition(!is_moved_(), moved_err_msg);
+    catch_up_();
+    return position_ == chunk_end_ && current_chunk_->is_final();
+  }
+
+  // Returns the unread remainder of the current chunk.
+  std::span<const value_type> current_span() const
+      requires std::ranges::contiguous_range<chunk_type> {
+    precondition(!is_moved_(), moved_err_msg);
+    catch_up_();
+
+    auto remaining = std::ranges::distance(position_, chunk_end_);
+    return {std::to_address(position_), static_cast<std::size_t>(remaining)};
+  }
+
+  // Skips n elements, which must all be currently available.
+  void advance(difference_type n) {
+    precondition(!is_moved_(), moved_err_msg);
+    precondition(n >= 0);
+
+    n = std::ranges::advance(position_, n, chunk_end_);
+    while (n > 0) {
+      auto* next = current_chunk_->next();
+      precondition(next != nullptr, "advancing past the available data");
+
+      next->add_ref();
+      start_chunk_(details_::node_ptr<node_type>::adopt(next));
+      n = std::ranges::advance(position_, n, chunk_end_);
+    }
+  }
+
+  checkpoint_type checkpoint() {
+    precondition(!is_moved_(), moved_err_msg);
+    catch_up_();
+
+    return checkpoint_type{position_, current_chunk_};
+  }
+
+  void rollback(checkpoint_type cp) {
+    precondition(!is_moved_(), moved_err_msg);
+
+    position_ = std::move(cp.position_);
+    current_chunk_ = std::move(cp.current_chunk_);
+    chunk_end_ = current_chunk_->end();
+  }
+
+  // ***** Producer side *****
+
+  void append(ChunkT&& chunk) {
+    precondition(tail_ != nullptr, moved_err_msg);
+    precondition(!tail_->is_final());
+
+    if (std::ranges::empty(chunk)) {
+      return;
+    }
+
+    auto new_node = details_::allocate_node<node_type>(tail_->get_allocator(),
+                                                       std::move(chunk));
+    tail_->set_next(new_node);
+    tail_ = std::move(new_node);
+  }
+
+  void finish() {
+    precondition(tail_ != nullptr, moved_err_msg);
+    precondition(!tail_->is_final());
+
+    tail_->mark_final();
+  }
+
+ private:
+  bool is_moved_() const {
+    return current_chunk_ == nullptr;
+  }
+
+  // Moves into chunks that were published since we reached the end of the
+  // current one.
+  void catch_up_() const {
+    while (position_ == chunk_end_) {
+      auto* next = current_chunk_->next();
+      if (!next) {
+        return;
+      }
+
+      next->add_ref();
+      start_chunk_(details_::node_ptr<node_type>::adopt(next));
+    }
+  }
+
+  void start_chunk_(details_::node_ptr<node_type> chunk) const {
+    position_ = chunk->begin();
+    chunk_end_ = chunk->end();
+    current_chunk_ = std::move(chunk);
+  }
+
+  using chunk_iterator_type = std::ranges::iterator_t<node_type>;
+  using sentinel_type = std::ranges::sentinel_t<node_type>;
+
+  // The consumer's position only changes in const members when catching up
+  // with the producer, which is not observable from the feed interface.
+  mutable details_::node_ptr<node_type> current_chunk_;
+  mutable chunk_iterator_type position_;
+  mutable sentinel_type chunk_end_;
+
+  // Only ever touched by the producer.
+  details_::node_ptr<node_type> tail_;
+};
+
+}  // namespace abu::feed
+
+#endif
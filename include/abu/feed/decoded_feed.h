@@ -0,0 +1,378 @@
+// Copyright 2021 Francois Chabot
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ABU_FEED_DECODED_FEED_H
+#define ABU_FEED_DECODED_FEED_H
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "abu/feed/concepts.h"
+#include "abu/feed/debug.h"
+#include "abu/feed/tags.h"
+
+// Feeds that convert the elements of another feed, one block at a time.
+//
+// A decoder converts as much of a block of input as it can into a block of
+// output, and reports how much of each it used:
+//   decode_result operator()(std::span<const In> in,
+//                            std::span<Out> out,
+//                            bool last);
+//
+// It can leave elements it can't decode yet, like the start of an escape
+// sequence, at the end of in. They are handed back to it along with what
+// follows, and last is set once nothing ever will. Decoders are replayed on
+// rollbacks, so they must not carry state from one call to the next.
+
+namespace abu::feed {
+
+struct decode_result {
+  std::size_t consumed = 0;
+  std::size_t produced = 0;
+};
+
+template <typename D, typename In, typename Out>
+concept Decoder = requires(D& decoder,
+                           std::span<const In> in,
+                           std::span<Out> out,
+                           bool last) {
+  { decoder(in, out, last) } -> std::convertible_to<decode_result>;
+};
+
+namespace details_ {
+template <typename F>
+using source_feed_t = std::remove_reference_t<F>;
+
+template <typename F>
+using source_value_t = std::iter_value_t<source_feed_t<F>>;
+
+inline bool made_progress(const decode_result& result) {
+  return result.consumed > 0 || result.produced > 0;
+}
+
+template <typename Fn>
+struct transform_decoder {
+  template <typename In, typename Out>
+  decode_result operator()(std::span<const In> in, std::span<Out> out, bool) {
+    auto n = std::min(in.size(), out.size());
+    std::ranges::transform(in.first(n), out.begin(), std::ref(fn));
+    return {n, n};
+  }
+
+  Fn fn;
+};
+
+template <typename P>
+struct filter_decoder {
+  template <typename T>
+  decode_result operator()(std::span<const T> in, std::span<T> out, bool) {
+    auto n = std::min(in.size(), out.size());
+
+    // Every element is written, and only kept if it passes, which avoids
+    // branching on the predicate.
+    std::size_t produced = 0;
+    for (const auto& value : in.first(n)) {
+      out[produced] = value;
+      produced += static_cast<std::size_t>(std::invoke(pred, value));
+    }
+    return {n, produced};
+  }
+
+  P pred;
+};
+}  // namespace details_
+
+// Presents the output of a decoder run over a contiguous feed.
+//
+// usage:
+//   auto unescaped = abu::feed::decode(std::ref(data), unescape);
+//
+// The source is decoded a block at a time into a buffer, so it is read ahead
+// of the decoded feed by up to a buffer's worth of output, and shouldn't be
+// read from directly while the decoded feed is in use.
+//
+// Checkpoints hold on to the source's checkpoint from before the block they
+// were taken in. Rolling back re-decodes that block.
+template <typename F, typename D, typename T = details_::source_value_t<F>>
+requires ContiguousFeed<details_::source_feed_t<F>> &&
+    Decoder<D, details_::source_value_t<F>, T>
+class decoded_feed {
+  using source_type = details_::source_feed_t<F>;
+  using source_checkpoint_type =
+      decltype(std::declval<source_type&>().checkpoint());
+  using input_type = details_::source_value_t<F>;
+
+ public:
+  using iterator_tag = std::input_iterator_tag;
+  using difference_type = std::ptrdiff_t;
+  using value_type = T;
+
+  class checkpoint_type {
+   private:
+    friend class decoded_feed;
+
+    checkpoint_type(source_checkpoint_type source, std::size_t offset)
+        : source_(std::move(source)), offset_(offset) {}
+
+    source_checkpoint_type source_;
+
+    // How much output was read since source_.
+    std::size_t offset_;
+  };
+
+  static constexpr std::size_t default_buffer_size = 4096;
+
+  template <typename U>
+  explicit decoded_feed(U&& source,
+                        D decoder,
+                        std::size_t buffer_size = default_buffer_size)
+      : source_(std::forward<U>(source)),
+        decoder_(std::move(decoder)),
+        buffer_(buffer_size) {
+    precondition(buffer_size > 0);
+  }
+
+  const value_type& operator*() const {
+    fill_();
+    precondition(pos_ != size_);
+    return buffer_[pos_];
+  }
+
+  decoded_feed& operator++() {
+    fill_();
+    precondition(pos_ != size_);
+    ++pos_;
+    return *this;
+  }
+
+  void operator++(int) {
+    ++(*this);
+  }
+
+  bool operator==(const empty_feed_t&) const {
+    return !fill_();
+  }
+
+  bool operator==(const end_of_feed_t&) const {
+    return *this == empty && source_feed_() == end_of_feed;
+  }
+
+  // Returns the unread remainder of the current decoded block.
+  std::span<const value_type> current_span() const {
+    if (*this == empty) {
+      return {};
+    }
+    return std::span<const value_type>{buffer_}.subspan(pos_, size_ - pos_);
+  }
+
+  // Skips n elements, which must all be currently available.
+  void advance(difference_type n) {
+    precondition(n >= 0);
+
+    while (n > 0) {
+      auto block = current_span();
+      precondition(!block.empty(), "advancing past the available data");
+
+      auto step = std::min(n, std::ssize(block));
+      pos_ += static_cast<std::size_t>(step);
+      n -= step;
+    }
+  }
+
+  checkpoint_type checkpoint() {
+    if (pos_ == size_) {
+      return checkpoint_type{source_feed_().checkpoint(), 0};
+    }
+    return checkpoint_type{*batch_start_, pos_};
+  }
+
+  void rollback(checkpoint_type cp) {
+    source_feed_().rollback(std::move(cp.source_));
+    pos_ = 0;
+    size_ = 0;
+    batch_start_.reset();
+
+    // Blocks can come out differently this time around, but their contents
+    // don't.
+    for (auto skip = cp.offset_; skip > 0;) {
+      bool decoded = next_batch_();
+      precondition(decoded, "decoder output changed since the checkpoint");
+      if (!decoded) {
+        break;
+      }
+
+      pos_ = std::min(skip, size_);
+      skip -= pos_;
+    }
+  }
+
+ private:
+  source_type& source_feed_() const {
+    return details_::unwrap_member(source_);
+  }
+
+  void advance_source_(std::size_t n) const {
+    source_feed_().advance(
+        static_cast<std::iter_difference_t<source_type>>(n));
+  }
+
+  decode_result decode_(std::span<const input_type> in, bool last) const {
+    auto out = std::span<value_type>{buffer_};
+    auto result = std::invoke(decoder_, in, out, last);
+    assume(result.consumed <= in.size() && result.produced <= buffer_.size());
+    return result;
+  }
+
+  // Returns whether there is decoded output left to read, decoding the next
+  // block once the buffer has been read through.
+  bool fill_() const {
+    return pos_ != size_ || next_batch_();
+  }
+
+  // Fills the buffer with the next decoded block, which fails when more
+  // input is needed to decode anything.
+  bool next_batch_() const {
+    auto& src = source_feed_();
+    pos_ = 0;
+    size_ = 0;
+
+    while (src != empty) {
+      batch_start_.emplace(src.checkpoint());
+
+      auto result = decode_(src.current_span(), false);
+      if (details_::made_progress(result)) {
+        advance_source_(result.consumed);
+      } else {
+        result = decode_across_blocks_();
+        if (!details_::made_progress(result)) {
+          return false;
+        }
+      }
+
+      // Everything consumed could have been dropped.
+      size_ = result.produced;
+      if (size_ > 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // The next element straddles blocks of the source, which get stitched
+  // together until the decoder makes some progress.
+  decode_result decode_across_blocks_() const {
+    auto& src = source_feed_();
+    auto cp = src.checkpoint();
+
+    auto append_block = [&] {
+      auto block = src.current_span();
+      stitched_.insert(stitched_.end(), block.begin(), block.end());
+      advance_source_(block.size());
+    };
+
+    stitched_.clear();
+    append_block();
+
+    decode_result result;
+    while (true) {
+      bool last = src == end_of_feed;
+      if (!last) {
+        if (src == empty) {
+          break;
+        }
+        append_block();
+        last = src == end_of_feed;
+      }
+
+      result = decode_(stitched_, last);
+      if (details_::made_progress(result)) {
+        break;
+      }
+      precondition(!last, "decoder left input undecoded at the end of feed");
+      if (last) {
+        break;
+      }
+    }
+
+    src.rollback(std::move(cp));
+    advance_source_(result.consumed);
+    return result;
+  }
+
+  // Decoding happens as the decoded feed is looked at, which is not
+  // observable from the feed interface.
+  mutable details_::member_storage_t<F> source_;
+  mutable D decoder_;
+
+  mutable std::vector<value_type> buffer_;
+  mutable std::size_t pos_ = 0;
+  mutable std::size_t size_ = 0;
+  mutable std::optional<source_checkpoint_type> batch_start_;
+
+  // Holds input that straddles blocks of the source.
+  mutable std::vector<input_type> stitched_;
+};
+
+// Runs decoder over feed, which yields elements of type T. T defaults to the
+// feed's own value type.
+// usage:
+//   auto text = abu::feed::decode(std::ref(data), unescape);
+template <typename T = void, typename F, typename D>
+auto decode(F&& feed, D decoder) {
+  using source_type = details_::stored_feed_t<F>;
+  using value_type =
+      std::conditional_t<std::is_void_v<T>,
+                         details_::source_value_t<source_type>,
+                         T>;
+  using result_type = decoded_feed<source_type, D, value_type>;
+  return result_type{std::forward<F>(feed), std::move(decoder)};
+}
+
+// Applies fn to every element of feed, a whole block at a time, so that
+// simple functions get vectorized.
+// usage:
+//   auto lower = abu::feed::transform(std::ref(data), to_lower);
+template <typename F, typename Fn>
+auto transform(F&& feed, Fn fn) {
+  using source_type = details_::stored_feed_t<F>;
+  using decoder_type = details_::transform_decoder<Fn>;
+  using value_type = std::remove_cvref_t<std::invoke_result_t<
+      Fn&,
+      const details_::source_value_t<source_type>&>>;
+  using result_type = decoded_feed<source_type, decoder_type, value_type>;
+  return result_type{std::forward<F>(feed), decoder_type{std::move(fn)}};
+}
+
+// Only keeps the elements of feed that satisfy pred.
+// usage:
+//   auto no_spaces = abu::feed::filter(std::ref(data), is_not_space);
+template <typename F, typename P>
+auto filter(F&& feed, P pred) {
+  using source_type = details_::stored_feed_t<F>;
+  using decoder_type = details_::filter_decoder<P>;
+  using result_type = decoded_feed<source_type, decoder_type>;
+  return result_type{std::forward<F>(feed), decoder_type{std::move(pred)}};
+}
+
+}  // namespace abu::feed
+
+#endif
@@ -0,0 +1,278 @@
+// Copyright 2021 Francois Chabot
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ABU_FEED_FD_READER_H
+#define ABU_FEED_FD_READER_H
+
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <memory>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "abu/feed/debug.h"
+#include "abu/feed/stream.h"
+
+namespace abu::feed {
+
+class buffer_pool;
+
+// A fixed-capacity byte buffer borrowed from a buffer_pool.
+//
+// This is a contiguous Chunk. Its storage goes back to the pool when it is
+// destroyed, which for a stream happens once no checkpoint can reach it.
+class pooled_buffer {
+ public:
+  pooled_buffer(pooled_buffer&& other) noexcept
+      : pool_(std::exchange(other.pool_, nullptr)),
+        data_(std::exchange(other.data_, nullptr)),
+        size_(std::exchange(other.size_, 0)) {}
+
+  pooled_buffer& operator=(pooled_buffer&& other) noexcept {
+    if (this != &other) {
+      release_();
+      pool_ = std::exchange(other.pool_, nullptr);
+      data_ = std::exchange(other.data_, nullptr);
+      size_ = std::exchange(other.size_, 0);
+    }
+    return *this;
+  }
+
+  pooled_buffer(const pooled_buffer&) = delete;
+  pooled_buffer& operator=(const pooled_buffer&) = delete;
+
+  ~pooled_buffer() {
+    release_();
+  }
+
+  const char* begin() const {
+    return data_;
+  }
+
+  const char* end() const {
+    return data_ + size_;
+  }
+
+  char* data() {
+    return data_;
+  }
+
+  const char* data() const {
+    return data_;
+  }
+
+  std::size_t size() const {
+    return size_;
+  }
+
+  // Only keeps the first n bytes.
+  void shrink(std::size_t n) {
+    precondition(n <= size_);
+    size_ = n;
+  }
+
+ private:
+  friend class buffer_pool;
+
+  pooled_buffer(buffer_pool* pool, char* data, std::size_t size)
+      : pool_(pool), data_(data), size_(size) {}
+
+  inline void release_();
+
+  buffer_pool* pool_;
+  char* data_;
+  std::size_t size_;
+};
+
+// Hands out fixed-size buffers, and keeps them around for reuse once they
+// are released.
+//
+// The pool is not thread-safe, and must outlive all of its buffers.
+class buffer_pool {
+ public:
+  static constexpr std::size_t default_buffer_size = 64 * 1024;
+
+  explicit buffer_pool(std::size_t buffer_size = default_buffer_size)
+      : buffer_size_(buffer_size) {
+    precondition(buffer_size > 0);
+  }
+
+  buffer_pool(const buffer_pool&) = delete;
+  buffer_pool& operator=(const buffer_pool&) = delete;
+
+  ~buffer_pool() {
+    assume(free_.size() == storage_.size(),
+           "buffer_pool destroyed while buffers are still in use");
+  }
+
+  std::size_t buffer_size() const {
+    return buffer_size_;
+  }
+
+  // Number of buffers ready to be handed out without allocating.
+  std::size_t free_count() const {
+    return free_.size();
+  }
+
+  // Number of buffers ever allocated by the pool.
+  std::size_t capacity() const {
+    return storage_.size();
+  }
+
+  pooled_buffer acquire() {
+    if (free_.empty()) {
+      storage_.push_back(std::make_unique<char[]>(buffer_size_));
+      free_.reserve(storage_.size());
+      return {this, storage_.back().get(), buffer_size_};
+    }
+
+    auto* data = free_.back();
+    free_.pop_back();
+    return {this, data, buffer_size_};
+  }
+
+ private:
+  friend class pooled_buffer;
+
+  void release_(char* data) {
+    free_.push_back(data);
+  }
+
+  std::size_t buffer_size_;
+  std::vector<std::unique_ptr<char[]>> storage_;
+  std::vector<char*> free_;
+};
+
+void pooled_buffer::release_() {
+  if (data_) {
+    pool_->release_(data_);
+  }
+}
+
+// Reads from a POSIX file descriptor into pooled buffers, and appends them
+// to a stream.
+//
+// usage:
+//   abu::feed::buffer_pool pool;
+//   abu::feed::stream<abu::feed::pooled_buffer> data;
+//   abu::feed::fd_reader reader{fd, pool};
+//
+//   while (data != abu::feed::end_of_feed) {
+//     reader.read_into(data);
+//     consume(data);
+//   }
+//
+// The file descriptor is not owned by the reader. Errors are reported as
+// std::system_error.
+class fd_reader {
+ public:
+  static constexpr std::size_t default_max_batch = 8;
+
+  fd_reader(int fd,
+            buffer_pool& pool,
+            std::size_t max_batch = default_max_batch)
+      : fd_(fd), pool_(&pool), max_batch_(max_batch) {
+    precondition(max_batch > 0);
+    batch_.reserve(max_batch);
+    iov_.reserve(max_batch);
+  }
+
+  // Performs a single read, spread over up to max_batch buffers. Buffers that
+  // end up unused go straight back to the pool.
+  // Returns the number of bytes appended to dst. This is 0 either when the
+  // descriptor is non-blocking and has no data, or when the end of the file
+  // was reached, in which case dst is finished.
+  //
+  // The number of buffers follows the size of recent reads: it doubles when
+  // a read fills all of them, and drops to what was used otherwise.
+  template <typename Alloc>
+  std::size_t read_into(stream<pooled_buffer, Alloc>& dst) {
+    // Leaves the batch empty however this returns, so that a throwing
+    // acquire() or append() can't leave stale buffers for the next call.
+    struct batch_guard {
+      explicit batch_guard(fd_reader& in_self) : self(in_self) {
+        self.clear_batch_();
+      }
+      ~batch_guard() {
+        self.clear_batch_();
+      }
+
+      fd_reader& self;
+    } guard{*this};
+
+    for (std::size_t i = 0; i < batch_size_; ++i) {
+      auto& buf = batch_.emplace_back(pool_->acquire());
+      iov_.push_back({buf.data(), buf.size()});
+    }
+
+    ::ssize_t n;
+    do {
+      n = ::readv(fd_, iov_.data(), static_cast<int>(iov_.size()));
+    } while (n < 0 && errno == EINTR);
+    auto err = errno;
+
+    if (n < 0) {
+      if (err == EAGAIN || err == EWOULDBLOCK) {
+        return 0;
+      }
+      throw std::system_error(err, std::generic_category(), "readv");
+    }
+
+    auto capacity = iov_.size() * pool_->buffer_size();
+    std::size_t used = 0;
+    auto remaining = static_cast<std::size_t>(n);
+    for (auto& buf : batch_) {
+      if (remaining == 0) {
+        break;
+      }
+      auto len = std::min(remaining, buf.size());
+      buf.shrink(len);
+      remaining -= len;
+      dst.append(std::move(buf));
+      ++used;
+    }
+
+    if (n == 0) {
+      dst.finish();
+    } else if (static_cast<std::size_t>(n) == capacity) {
+      batch_size_ = std::min(batch_size_ * 2, max_batch_);
+    } else {
+      batch_size_ = used;
+    }
+    return static_cast<std::size_t>(n);
+  }
+
+ private:
+  void clear_batch_() {
+    batch_.clear();
+    iov_.clear();
+  }
+
+  int fd_;
+  buffer_pool* pool_;
+  std::size_t max_batch_;
+  std::size_t batch_size_ = max_batch_;
+
+  std::vector<pooled_buffer> batch_;
+  std::vector<::iovec> iov_;
+};
+
+}  // namespace abu::feed
+
+#endif
@@ -16,23 +16,54 @@
 #ifndef ABU_FEED_FORWARD_RANGE_ADAPTOR_H
 #define ABU_FEED_FORWARD_RANGE_ADAPTOR_H
 
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <type_traits>
+
 #include "abu/feed/debug.h"
+#include "abu/feed/location.h"
 #include "abu/feed/tags.h"
 
 namespace abu::feed {
 
+// Contiguous ranges are walked with raw pointers instead of I and S, which
+// keeps the per-element loop as tight as a plain pointer loop, even with
+// checked iterators.
+//
+// The adaptor also remembers where the range starts, so that offset() and
+// location_of() can measure from it. This costs one extra iterator per
+// adaptor.
 template <std::forward_iterator I, std::sentinel_for<I> S>
 class forward_range_adaptor {
- public:
-  using checkpoint_type = I;
+  static constexpr bool is_contiguous =
+      std::contiguous_iterator<I> && std::sized_sentinel_for<S, I>;
 
+ public:
   using iterator_tag = std::input_iterator_tag;
   using difference_type = std::iter_difference_t<I>;
   using value_type = std::iter_value_t<I>;
 
+  // Pointers keep the constness of the range, so that operator* still
+  // yields the iterator's reference type.
+  using checkpoint_type = std::conditional_t<
+      is_contiguous,
+      std::add_pointer_t<std::iter_reference_t<I>>,
+      I>;
+
   constexpr forward_range_adaptor() = default;
+
+  explicit constexpr forward_range_adaptor(I begin, S end)
+      requires(!is_contiguous)
+      : begin_(begin), position_(std::move(begin)), end_(std::move(end)) {}
+
   explicit constexpr forward_range_adaptor(I begin, S end)
-      : position_(std::move(begin)), end_(std::move(end)) {}
+      requires is_contiguous
+      : begin_(std::to_address(begin)),
+        position_(begin_),
+        end_(position_ + (end - begin)) {}
 
   constexpr decltype(auto) operator*() const {
     precondition(position_ != end_);
@@ -59,6 +90,22 @@ class forward_range_adaptor {
     return position_ == end_;
   }
 
+  // Returns the unread remainder of the range.
+  constexpr std::span<const value_type> current_span() const
+      requires is_contiguous {
+    return {std::to_address(position_),
+            static_cast<std::size_t>(end_ - position_)};
+  }
+
+  // Skips n elements, which must all be available.
+  constexpr void advance(difference_type n) {
+    precondition(n >= 0);
+
+    n = std::ranges::advance(position_, n, end_);
+
+    precondition(n == 0, "advancing past the available data");
+  }
+
   constexpr checkpoint_type checkpoint() {
     return position_;
   }
@@ -67,9 +114,49 @@ class forward_range_adaptor {
     position_ = std::move(cp);
   }
 
+  // Returns how many elements precede the current position in the range.
+  constexpr std::size_t offset() const {
+    return offset_of(position_);
+  }
+
+  constexpr std::size_t offset_of(const checkpoint_type& cp) const {
+    return static_cast<std::size_t>(std::ranges::distance(begin_, cp));
+  }
+
+  constexpr difference_type distance(const checkpoint_type& from,
+                                     const checkpoint_type& to) const {
+    return static_cast<difference_type>(std::ranges::distance(from, to));
+  }
+
+  // Returns the elements between two checkpoints, from preceding to, as a
+  // view of the range.
+  constexpr auto slice(const checkpoint_type& from,
+                       const checkpoint_type& to) const {
+    if constexpr (is_contiguous) {
+      precondition(from <= to, "slicing backwards");
+      return std::span<const value_type>{from, to};
+    } else {
+      return std::ranges::subrange<I>{from, to};
+    }
+  }
+
+  // Lines are counted from the start of the range every time.
+  location location_of(const checkpoint_type& cp) const
+      requires is_contiguous && details_::line_countable<value_type> {
+    return details_::advance_location_(
+        location{}, std::span<const value_type>{begin_, cp});
+  }
+
+  location current_location() const
+      requires is_contiguous && details_::line_countable<value_type> {
+    return location_of(position_);
+  }
+
  private:
-  I position_;
-  [[no_unique_address]] S end_;
+  checkpoint_type begin_;
+  checkpoint_type position_;
+  [[no_unique_address]] std::conditional_t<is_contiguous, checkpoint_type, S>
+      end_;
 };
 
 }  // namespace abu::feed
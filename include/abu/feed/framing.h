@@ -0,0 +1,359 @@
+// Copyright 2021 Francois Chabot
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ABU_FEED_FRAMING_H
+#define ABU_FEED_FRAMING_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "abu/feed/algorithm.h"
+#include "abu/feed/debug.h"
+#include "abu/feed/lookahead.h"
+#include "abu/feed/stream.h"
+#include "abu/feed/tags.h"
+
+// Splitting a stream of bytes into frames.
+//
+// A framing locates the next frame at the front of a stream, without moving
+// it:
+//   std::optional<frame_layout> locate(const stream<ChunkT, Alloc>& data);
+//
+// It returns std::nullopt when it needs more data to do so, and throws
+// framing_error when the data can't be framed. The frame itself doesn't have
+// to be available yet, frame_reader waits for it.
+
+namespace abu::feed {
+
+class framing_error : public std::runtime_error {
+ public:
+  using std::runtime_error::runtime_error;
+};
+
+struct frame_layout {
+  // Skipped before the payload.
+  std::size_t header = 0;
+  std::size_t payload = 0;
+  // Skipped after the payload.
+  std::size_t trailer = 0;
+};
+
+namespace details_ {
+inline constexpr std::size_t unlimited_frame_size =
+    std::numeric_limits<std::size_t>::max();
+
+template <typename T>
+std::uint8_t as_octet(const T& v) {
+  return static_cast<std::uint8_t>(v);
+}
+
+inline void check_frame_size(std::uint64_t size, std::size_t max_size) {
+  if (size > max_size) {
+    throw framing_error("frame exceeds the maximum frame size");
+  }
+}
+}  // namespace details_
+
+// Frames are terminated by a delimiter, which is not part of the payload.
+// The data left over once the stream is finished forms a last frame.
+//
+// usage:
+//   abu::feed::delimited_framing lines{"\n"sv};
+template <typename T>
+class delimited_framing {
+ public:
+  template <std::ranges::contiguous_range R>
+  explicit delimited_framing(
+      const R& delim,
+      std::size_t max_size = details_::unlimited_frame_size)
+      : delim_(std::ranges::begin(delim), std::ranges::end(delim)),
+        max_size_(max_size) {
+    precondition(!delim_.empty());
+  }
+
+  template <typename StreamT>
+  std::optional<frame_layout> locate(const StreamT& data) {
+    if (scanned_ == 0) {
+      // Most frames end within the current chunk.
+      auto here = data.current_span();
+      std::size_t payload = 0;
+      while (true) {
+        payload += details_::find_in_(here.subspan(payload), delim_.front());
+        if (here.size() - payload < delim_.size()) {
+          break;
+        }
+        if (std::ranges::equal(here.subspan(payload, delim_.size()),
+                               delim_)) {
+          details_::check_frame_size(payload, max_size_);
+          return frame_layout{.payload = payload, .trailer = delim_.size()};
+        }
+        ++payload;
+      }
+    }
+
+    // Picks up the search where the last attempt ran out of data.
+    auto cursor = data.cursor();
+    cursor.advance(static_cast<std::ptrdiff_t>(scanned_));
+
+    std::ptrdiff_t skipped = 0;
+    bool found = details_::skip_until_(
+        cursor, std::span<const T>{delim_}, skipped);
+    auto payload = scanned_ + static_cast<std::size_t>(skipped);
+
+    if (found) {
+      scanned_ = 0;
+      details_::check_frame_size(payload, max_size_);
+      return frame_layout{.payload = payload, .trailer = delim_.size()};
+    }
+
+    // What's left can only be the start of a delimiter.
+    std::size_t rest = 0;
+    while (cursor != empty) {
+      auto block = cursor.current_span();
+      rest += block.size();
+      cursor.advance(std::ssize(block));
+    }
+
+    if (cursor == end_of_feed) {
+      // The left over data forms the last frame.
+      scanned_ = 0;
+      payload += rest;
+      if (payload == 0) {
+        return std::nullopt;
+      }
+      details_::check_frame_size(payload, max_size_);
+      return frame_layout{.payload = payload};
+    }
+
+    scanned_ = payload;
+    details_::check_frame_size(scanned_, max_size_);
+    return std::nullopt;
+  }
+
+ private:
+  std::vector<T> delim_;
+  std::size_t max_size_;
+  std::size_t scanned_ = 0;
+};
+
+template <std::ranges::contiguous_range R>
+delimited_framing(const R&) -> delimited_framing<std::ranges::range_value_t<R>>;
+
+template <std::ranges::contiguous_range R>
+delimited_framing(const R&, std::size_t)
+    -> delimited_framing<std::ranges::range_value_t<R>>;
+
+// Frames are preceded by their size, as a protobuf-style base 128 varint.
+class varint_length_framing {
+ public:
+  static constexpr std::size_t max_header_size = 10;
+
+  explicit varint_length_framing(
+      std::size_t max_size = details_::unlimited_frame_size)
+      : max_size_(max_size) {}
+
+  template <typename StreamT>
+  std::optional<frame_layout> locate(const StreamT& data) const {
+    auto head = data.template peek<max_header_size>(max_header_size);
+    auto bytes = head.data();
+
+    std::uint64_t size = 0;
+    for (std::size_t i = 0; i < bytes.size(); ++i) {
+      auto byte = details_::as_octet(bytes[i]);
+      if (i == max_header_size - 1 && byte > 1) {
+        // Past the 64 bits of the size.
+        throw framing_error("malformed varint frame size");
+      }
+      size |= std::uint64_t{byte & 0x7fu} << (7 * i);
+      if ((byte & 0x80u) == 0) {
+        details_::check_frame_size(size, max_size_);
+        return frame_layout{.header = i + 1,
+                            .payload = static_cast<std::size_t>(size)};
+      }
+    }
+
+    if (bytes.size() == max_header_size) {
+      throw framing_error("malformed varint frame size");
+    }
+    if (head.status() == peek_status::finished && !bytes.empty()) {
+      throw framing_error("truncated frame");
+    }
+    return std::nullopt;
+  }
+
+ private:
+  std::size_t max_size_;
+};
+
+// Frames are preceded by their size, as a 4 bytes big-endian integer.
+class be32_length_framing {
+ public:
+  static constexpr std::size_t header_size = 4;
+
+  explicit be32_length_framing(
+      std::size_t max_size = details_::unlimited_frame_size)
+      : max_size_(max_size) {}
+
+  template <typename StreamT>
+  std::optional<frame_layout> locate(const StreamT& data) const {
+    auto head = data.template peek<header_size>(header_size);
+    if (!head.ok()) {
+      if (head.status() == peek_status::finished && !head.data().empty()) {
+        throw framing_error("truncated frame");
+      }
+      return std::nullopt;
+    }
+
+    std::uint32_t size = 0;
+    for (auto byte : head.data()) {
+      size = (size << 8) | details_::as_octet(byte);
+    }
+    details_::check_frame_size(size, max_size_);
+    return frame_layout{.header = header_size, .payload = size};
+  }
+
+ private:
+  std::size_t max_size_;
+};
+
+// Presents the frames of a stream as a feed of ropes.
+//
+// usage:
+//   abu::feed::frame_reader frames{data, abu::feed::delimited_framing{"\n"sv}};
+//   while (frames != abu::feed::empty) {
+//     handle(*frames);
+//     ++frames;
+//   }
+//
+// A frame that sits within a single chunk is a view of it, and one that
+// straddles chunks refers to each of them, so the payload is never copied.
+// Frames keep their chunks alive, and remain valid once the reader has moved
+// on. Partial frames are picked up where they were left once more data is
+// appended to the stream.
+template <typename FramingT, Chunk ChunkT, typename Alloc>
+requires details_::contiguous_chunk<const ChunkT>
+class frame_reader {
+  static constexpr const char* moved_err_msg =
+      "Using frame reader that was moved";
+
+ public:
+  using stream_type = stream<ChunkT, Alloc>;
+  using value_type = typename stream_type::rope_type;
+
+  using iterator_tag = std::input_iterator_tag;
+  using difference_type = std::ptrdiff_t;
+
+  frame_reader(stream_type& source, FramingT framing)
+      : source_(&source), framing_(std::move(framing)) {}
+
+  const value_type& operator*() const {
+    precondition(source_ != nullptr, moved_err_msg);
+    locate_next_();
+    precondition(current_.has_value());
+    return *current_;
+  }
+
+  frame_reader& operator++() {
+    precondition(source_ != nullptr, moved_err_msg);
+    locate_next_();
+    precondition(current_.has_value());
+    current_.reset();
+    return *this;
+  }
+
+  void operator++(int) {
+    ++(*this);
+  }
+
+  bool operator==(const empty_feed_t&) const {
+    precondition(source_ != nullptr, moved_err_msg);
+    return !locate_next_();
+  }
+
+  bool operator==(const end_of_feed_t&) const {
+    return *this == empty && *source_ == end_of_feed;
+  }
+
+ private:
+  // Returns whether a frame is ready to be read.
+  bool locate_next_() const {
+    return current_ || next_frame_();
+  }
+
+  bool next_frame_() const {
+    if (!pending_) {
+      pending_ = framing_.locate(std::as_const(*source_));
+      if (!pending_) {
+        return false;
+      }
+    }
+
+    auto [header, payload, trailer] = *pending_;
+    auto needed = header + payload + trailer;
+
+    // Frames that sit in the current chunk don't need to be counted.
+    if (source_->current_span().size() < needed) {
+      if (!probe_) {
+        probe_.emplace(source_->cursor());
+        probed_ = 0;
+      }
+
+      while (probed_ < needed) {
+        if (*probe_ == empty) {
+          if (*probe_ == end_of_feed) {
+            throw framing_error("truncated frame");
+          }
+          return false;
+        }
+
+        auto n = std::min(needed - probed_, probe_->current_span().size());
+        probe_->advance(static_cast<std::ptrdiff_t>(n));
+        probed_ += n;
+      }
+    }
+    probe_.reset();
+
+    source_->advance(static_cast<std::ptrdiff_t>(header));
+    current_ = source_->rope(payload);
+    source_->advance(static_cast<std::ptrdiff_t>(payload + trailer));
+    pending_.reset();
+    return true;
+  }
+
+  stream_type* source_;
+
+  // Frames are only pulled out of the stream when looked for, which is not
+  // observable from the feed interface.
+  mutable FramingT framing_;
+  mutable std::optional<value_type> current_;
+
+  // The frame that has been located, but is not fully available yet, and how
+  // much of it has been seen so far.
+  mutable std::optional<frame_layout> pending_;
+  mutable std::optional<typename stream_type::cursor_type> probe_;
+  mutable std::size_t probed_ = 0;
+};
+
+}  // namespace abu::feed
+
+#endif
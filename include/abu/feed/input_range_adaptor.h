@@ -0,0 +1,318 @@
+// Copyright 2021 Francois Chabot
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ABU_FEED_INPUT_RANGE_ADAPTOR_H
+#define ABU_FEED_INPUT_RANGE_ADAPTOR_H
+
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "abu/feed/debug.h"
+#include "abu/feed/node_ptr.h"
+#include "abu/feed/tags.h"
+#include "abu/mem.h"
+
+namespace abu::feed {
+
+template <std::input_iterator I, std::sentinel_for<I> S>
+class input_range_adaptor;
+
+namespace details_ {
+
+// Shared between an input_range_adaptor and its rollback chunks so that the
+// adaptor knows when nothing can roll back into the buffer anymore.
+struct rollback_buffer_state {
+  std::size_t live_checkpoints = 0;
+};
+
+// A fixed-capacity segment of the rollback buffer. Segments are chained
+// front-to-back, so holding a reference to one keeps everything after it
+// alive, the same way stream nodes are retained.
+template <typename T>
+class rollback_chunk {
+ public:
+  static node_ptr<rollback_chunk> make(
+      std::size_t capacity,
+      mem::ref_count_ptr<rollback_buffer_state> state) {
+    return node_ptr<rollback_chunk>::adopt(
+        new rollback_chunk(capacity, std::move(state)));
+  }
+
+  const T& operator[](std::size_t i) const {
+    assume(i < data_.size());
+    return data_[i];
+  }
+
+  std::size_t size() const {
+    return data_.size();
+  }
+
+  bool full() const {
+    return data_.size() == data_.capacity();
+  }
+
+  template <typename U>
+  void push(U&& v) {
+    assume(!full());
+    data_.emplace_back(std::forward<U>(v));
+  }
+
+  // Reuses the chunk's storage from the start.
+  void clear() {
+    assume(!next_);
+    data_.clear();
+  }
+
+  void set_next(node_ptr<rollback_chunk> next) {
+    assume(!next_);
+    next_ = std::move(next);
+  }
+
+  const node_ptr<rollback_chunk>& next() const {
+    return next_;
+  }
+
+  rollback_buffer_state& state() const {
+    return *state_;
+  }
+
+  // node_ptr interface
+  void add_ref() noexcept {
+    ++ref_count_;
+  }
+
+  bool release_ref() noexcept {
+    return --ref_count_ == 0;
+  }
+
+  node_ptr<rollback_chunk> detach_next() noexcept {
+    return std::move(next_);
+  }
+
+  static void destroy(rollback_chunk* chunk) noexcept {
+    delete chunk;
+  }
+
+ private:
+  rollback_chunk(std::size_t capacity,
+                 mem::ref_count_ptr<rollback_buffer_state> state)
+      : state_(std::move(state)) {
+    data_.reserve(capacity);
+  }
+
+  std::size_t ref_count_ = 1;
+  std::vector<T> data_;
+  node_ptr<rollback_chunk> next_;
+  mem::ref_count_ptr<rollback_buffer_state> state_;
+};
+
+template <typename T>
+class input_checkpoint {
+ public:
+  input_checkpoint(const input_checkpoint& other)
+      : chunk_(other.chunk_), index_(other.index_) {
+    acquire_();
+  }
+
+  input_checkpoint(input_checkpoint&& other)
+      : chunk_(std::exchange(other.chunk_, {})), index_(other.index_) {}
+
+  input_checkpoint& operator=(const input_checkpoint& other) {
+    if (this != &other) {
+      release_();
+      chunk_ = other.chunk_;
+      index_ = other.index_;
+      acquire_();
+    }
+    return *this;
+  }
+
+  input_checkpoint& operator=(input_checkpoint&& other) {
+    if (this != &other) {
+      release_();
+      chunk_ = std::exchange(other.chunk_, {});
+      index_ = other.index_;
+    }
+    return *this;
+  }
+
+  ~input_checkpoint() {
+    release_();
+  }
+
+ private:
+  template <std::input_iterator I, std::sentinel_for<I> S>
+  friend class abu::feed::input_range_adaptor;
+
+  input_checkpoint(node_ptr<rollback_chunk<T>> chunk, std::size_t index)
+      : chunk_(std::move(chunk)), index_(index) {
+    acquire_();
+  }
+
+  void acquire_() {
+    if (chunk_) {
+      ++chunk_->state().live_checkpoints;
+    }
+  }
+
+  void release_() {
+    if (chunk_) {
+      --chunk_->state().live_checkpoints;
+    }
+  }
+
+  node_ptr<rollback_chunk<T>> chunk_;
+  std::size_t index_ = 0;
+};
+}  // namespace details_
+
+// Presents a single-pass iterator/sentinel pair as a feed.
+//
+// Elements are only copied into the rollback buffer while at least one
+// checkpoint is alive, and buffer chunks are released as soon as the oldest
+// checkpoint referencing them is dropped.
+template <std::input_iterator I, std::sentinel_for<I> S>
+class input_range_adaptor {
+ public:
+  static constexpr std::size_t default_chunk_size = 256;
+
+  using value_type = std::iter_value_t<I>;
+  using chunk_type = details_::rollback_chunk<value_type>;
+  using checkpoint_type = details_::input_checkpoint<value_type>;
+
+  using iterator_tag = std::input_iterator_tag;
+  using difference_type = std::iter_difference_t<I>;
+  using reference =
+      std::common_reference_t<std::iter_reference_t<I>, const value_type&>;
+
+  input_range_adaptor() requires std::default_initializable<I> &&
+      std::default_initializable<S> : input_range_adaptor(I{}, S{}) {}
+
+  explicit input_range_adaptor(I begin,
+                               S end,
+                               std::size_t chunk_size = default_chunk_size)
+      : position_(std::move(begin)),
+        end_(std::move(end)),
+        chunk_size_(chunk_size),
+        state_(mem::make_ref_counted<details_::rollback_buffer_state>()),
+        tail_(chunk_type::make(chunk_size_, state_)),
+        current_(tail_) {
+    precondition(chunk_size > 0);
+  }
+
+  // Copies would share the rollback buffer with the original.
+  input_range_adaptor(const input_range_adaptor&) = delete;
+  input_range_adaptor(input_range_adaptor&&) = default;
+  input_range_adaptor& operator=(const input_range_adaptor&) = delete;
+  input_range_adaptor& operator=(input_range_adaptor&&) = default;
+
+  reference operator*() const {
+    if (replaying_()) {
+      return (*current_)[index_];
+    }
+
+    precondition(position_ != end_);
+    return *position_;
+  }
+
+  input_range_adaptor& operator++() {
+    if (replaying_()) {
+      ++index_;
+      if (index_ == current_->size() && current_ != tail_) {
+        current_ = current_->next();
+        index_ = 0;
+      }
+      return *this;
+    }
+
+    precondition(position_ != end_);
+
+    if (state_->live_checkpoints == 0) {
+      // Nothing can roll back here, so there is no need to record anything.
+      drop_buffer_();
+    } else {
+      if (tail_->full()) {
+        auto next = chunk_type::make(chunk_size_, state_);
+        tail_->set_next(next);
+        tail_ = std::move(next);
+        current_ = tail_;
+        index_ = 0;
+      }
+      tail_->push(*position_);
+      ++index_;
+    }
+
+    ++position_;
+    return *this;
+  }
+
+  void operator++(int) {
+    ++(*this);
+  }
+
+  bool operator==(const empty_feed_t&) const {
+    return !replaying_() && position_ == end_;
+  }
+
+  bool operator==(const end_of_feed_t&) const {
+    return !replaying_() && position_ == end_;
+  }
+
+  checkpoint_type checkpoint() {
+    if (!replaying_() && state_->live_checkpoints == 0) {
+      drop_buffer_();
+    }
+    return checkpoint_type{current_, index_};
+  }
+
+  void rollback(checkpoint_type cp) {
+    precondition(cp.chunk_ != nullptr);
+
+    current_ = cp.chunk_;
+    index_ = cp.index_;
+
+    // This happens when checkpointing at the end of a full chunk.
+    if (index_ == current_->size() && current_ != tail_) {
+      current_ = current_->next();
+      index_ = 0;
+    }
+  }
+
+ private:
+  bool replaying_() const {
+    return index_ != current_->size() || current_ != tail_;
+  }
+
+  void drop_buffer_() {
+    assume(current_ == tail_);
+    if (index_ != 0) {
+      tail_->clear();
+      index_ = 0;
+    }
+  }
+
+  I position_;
+  [[no_unique_address]] S end_;
+
+  std::size_t chunk_size_;
+  mem::ref_count_ptr<details_::rollback_buffer_state> state_;
+  details_::node_ptr<chunk_type> tail_;
+  details_::node_ptr<chunk_type> current_;
+  std::size_t index_ = 0;
+};
+
+}  // namespace abu::feed
+
+#endif
@@ -0,0 +1,62 @@
+// Copyright 2021 Francois Chabot
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ABU_FEED_LOCATION_H
+#define ABU_FEED_LOCATION_H
+
+#include <algorithm>
+#include <cstddef>
+#include <span>
+
+#include "abu/feed/algorithm.h"
+
+namespace abu::feed {
+
+// Where an element sits within everything a feed has produced.
+//
+// Lines and columns start at 1, and columns count elements, not characters.
+struct location {
+  std::size_t offset = 0;
+  std::size_t line = 1;
+  std::size_t column = 1;
+
+  friend bool operator==(const location&, const location&) = default;
+};
+
+namespace details_ {
+template <typename T>
+concept line_countable = byte_like<T>;
+
+// Moves from, the location of the first element of data, past all of it.
+template <line_countable T>
+location advance_location_(location from, std::span<const T> data) {
+  const auto newline = static_cast<T>('\n');
+
+  from.offset += data.size();
+  auto lines = count_in_(data, newline);
+  if (lines == 0) {
+    from.column += data.size();
+    return from;
+  }
+
+  auto last = std::find(data.rbegin(), data.rend(), newline);
+  from.line += lines;
+  from.column = static_cast<std::size_t>(last - data.rbegin()) + 1;
+  return from;
+}
+}  // namespace details_
+
+}  // namespace abu::feed
+
+#endif
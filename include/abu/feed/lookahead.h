@@ -0,0 +1,104 @@
+// Copyright 2021 Francois Chabot
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ABU_FEED_LOOKAHEAD_H
+#define ABU_FEED_LOOKAHEAD_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+
+#include "abu/feed/debug.h"
+
+namespace abu::feed {
+
+// Largest lookahead supported by peek() unless specified otherwise.
+inline constexpr std::size_t default_max_peek = 8;
+
+enum class peek_status {
+  ok,
+  // Fewer elements are available, but more might still come.
+  need_more,
+  // Fewer elements are available, and the feed is finished.
+  finished
+};
+
+enum class match_status {
+  match,
+  mismatch,
+  // What is available matches, but more data is needed to decide.
+  need_more
+};
+
+// The upcoming elements of a feed, as returned by peek().
+//
+// When they all sit in a single chunk, this refers to the feed's own data,
+// which stays valid until the feed moves. Otherwise, they are stitched
+// together in a small internal buffer.
+template <typename T, std::size_t MaxN = default_max_peek>
+requires std::is_trivially_copyable_v<T>
+class peek_result {
+ public:
+  // Refers to data owned by the feed.
+  static constexpr peek_result viewing(peek_status status,
+                                       std::span<const T> data) {
+    peek_result result{status, data.size()};
+    result.direct_ = data.data();
+    return result;
+  }
+
+  // Keeps a copy of data.
+  static constexpr peek_result copying(peek_status status,
+                                       std::span<const T> data) {
+    precondition(data.size() <= MaxN);
+
+    peek_result result{status, data.size()};
+    std::ranges::copy(data, result.stitched_.begin());
+    return result;
+  }
+
+  constexpr peek_status status() const {
+    return status_;
+  }
+
+  constexpr bool ok() const {
+    return status_ == peek_status::ok;
+  }
+
+  // All of the requested elements when ok(), and whatever was available
+  // otherwise.
+  constexpr std::span<const T> data() const {
+    return {direct_ ? direct_ : stitched_.data(), size_};
+  }
+
+  constexpr const T& operator[](std::size_t i) const {
+    precondition(i < size_);
+    return data()[i];
+  }
+
+ private:
+  constexpr peek_result(peek_status status, std::size_t size)
+      : status_(status), size_(size) {}
+
+  peek_status status_;
+  std::size_t size_;
+  const T* direct_ = nullptr;
+  std::array<T, MaxN> stitched_{};
+};
+
+}  // namespace abu::feed
+
+#endif
@@ -0,0 +1,228 @@
+// Copyright 2021 Francois Chabot
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ABU_FEED_MAPPED_FILE_H
+#define ABU_FEED_MAPPED_FILE_H
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <system_error>
+#include <utility>
+
+#include "abu/feed/debug.h"
+#include "abu/feed/stream.h"
+
+namespace abu::feed {
+
+// A read-only mapping of a section of a file.
+//
+// This is a contiguous Chunk, so it can be appended to a stream. The section
+// gets unmapped as soon as the stream drops it.
+class mapped_window {
+ public:
+  mapped_window(mapped_window&& other) noexcept
+      : data_(std::exchange(other.data_, nullptr)),
+        size_(std::exchange(other.size_, 0)),
+        offset_(other.offset_) {}
+
+  mapped_window& operator=(mapped_window&& other) noexcept {
+    if (this != &other) {
+      unmap_();
+      data_ = std::exchange(other.data_, nullptr);
+      size_ = std::exchange(other.size_, 0);
+      offset_ = other.offset_;
+    }
+    return *this;
+  }
+
+  mapped_window(const mapped_window&) = delete;
+  mapped_window& operator=(const mapped_window&) = delete;
+
+  ~mapped_window() {
+    unmap_();
+  }
+
+  const char* begin() const {
+    return static_cast<const char*>(data_);
+  }
+
+  const char* end() const {
+    return begin() + size_;
+  }
+
+  const char* data() const {
+    return begin();
+  }
+
+  std::size_t size() const {
+    return size_;
+  }
+
+  // Position of the window within the file.
+  std::size_t offset() const {
+    return offset_;
+  }
+
+ private:
+  friend class mapped_file;
+
+  mapped_window(void* data, std::size_t size, std::size_t offset)
+      : data_(data), size_(size), offset_(offset) {}
+
+  void unmap_() {
+    if (data_) {
+      ::munmap(data_, size_);
+    }
+  }
+
+  void* data_;
+  std::size_t size_;
+  std::size_t offset_;
+};
+
+// Maps a file into memory, one window at a time.
+//
+// usage:
+//   abu::feed::mapped_file file{"data.log"};
+//   abu::feed::stream<abu::feed::mapped_window> data;
+//   while (file.append_next_window(data)) {
+//     consume(data);
+//   }
+//
+// Files smaller than window_size are mapped in a single window. I/O errors
+// are reported as std::system_error.
+class mapped_file {
+ public:
+  static constexpr std::size_t default_window_size = std::size_t{1} << 30;
+
+  explicit mapped_file(const char* path,
+                       std::size_t window_size = default_window_size) {
+    fd_ = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) {
+      throw std::system_error(errno, std::generic_category(), path);
+    }
+
+    struct ::stat info;
+    if (::fstat(fd_, &info) != 0) {
+      auto err = errno;
+      ::close(fd_);
+      throw std::system_error(err, std::generic_category(), path);
+    }
+    size_ = static_cast<std::size_t>(info.st_size);
+
+    // Windows have to start on page boundaries.
+    auto page_size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    window_size_ = std::max(window_size / page_size, std::size_t{1});
+    window_size_ *= page_size;
+  }
+
+  mapped_file(mapped_file&& other) noexcept
+      : fd_(std::exchange(other.fd_, -1)),
+        size_(other.size_),
+        window_size_(other.window_size_),
+        next_offset_(other.next_offset_),
+        finished_(other.finished_) {}
+
+  mapped_file& operator=(mapped_file&& other) noexcept {
+    if (this != &other) {
+      close_();
+      fd_ = std::exchange(other.fd_, -1);
+      size_ = other.size_;
+      window_size_ = other.window_size_;
+      next_offset_ = other.next_offset_;
+      finished_ = other.finished_;
+    }
+    return *this;
+  }
+
+  mapped_file(const mapped_file&) = delete;
+  mapped_file& operator=(const mapped_file&) = delete;
+
+  ~mapped_file() {
+    close_();
+  }
+
+  std::size_t size() const {
+    return size_;
+  }
+
+  std::size_t window_size() const {
+    return window_size_;
+  }
+
+  // Whether every window of the file has been handed out.
+  bool done() const {
+    return next_offset_ >= size_;
+  }
+
+  mapped_window next_window() {
+    precondition(fd_ >= 0, "Using mapped_file that was moved");
+    precondition(!done());
+
+    auto len = std::min(window_size_, size_ - next_offset_);
+    void* data = ::mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd_,
+                        static_cast<::off_t>(next_offset_));
+    if (data == MAP_FAILED) {
+      throw std::system_error(errno, std::generic_category(), "mmap");
+    }
+    ::madvise(data, len, MADV_SEQUENTIAL);
+
+    mapped_window result{data, len, next_offset_};
+    next_offset_ += len;
+    return result;
+  }
+
+  // Appends the next window to the stream, and finishes the stream once the
+  // whole file has been appended.
+  // Returns false if the stream was already finished.
+  template <typename Alloc>
+  bool append_next_window(stream<mapped_window, Alloc>& dst) {
+    if (finished_) {
+      return false;
+    }
+
+    if (!done()) {
+      dst.append(next_window());
+    }
+
+    if (done()) {
+      dst.finish();
+      finished_ = true;
+    }
+    return true;
+  }
+
+ private:
+  void close_() {
+    if (fd_ >= 0) {
+      ::close(fd_);
+    }
+  }
+
+  int fd_ = -1;
+  std::size_t size_ = 0;
+  std::size_t window_size_ = 0;
+  std::size_t next_offset_ = 0;
+  bool finished_ = false;
+};
+
+}  // namespace abu::feed
+
+#endif
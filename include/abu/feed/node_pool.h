@@ -0,0 +1,140 @@
+// Copyright 2021 Francois Chabot
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ABU_FEED_NODE_POOL_H
+#define ABU_FEED_NODE_POOL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <vector>
+
+#include "abu/feed/debug.h"
+
+namespace abu::feed {
+
+// A free list of same-sized blocks, carved out of slabs.
+//
+// Released blocks are kept for reuse until the pool itself is destroyed, so
+// once a stream has reached its steady state, appending and releasing chunks
+// never reaches the global allocator.
+//
+// The pool is not thread-safe, and must outlive everything allocated from it,
+// checkpoints included.
+class node_pool {
+ public:
+  static constexpr std::size_t default_blocks_per_slab = 64;
+
+  explicit node_pool(std::size_t blocks_per_slab = default_blocks_per_slab)
+      : blocks_per_slab_(blocks_per_slab) {
+    precondition(blocks_per_slab > 0);
+  }
+
+  node_pool(const node_pool&) = delete;
+  node_pool& operator=(const node_pool&) = delete;
+
+  ~node_pool() {
+    for (auto* slab : slabs_) {
+      ::operator delete(slab, std::align_val_t{block_align_});
+    }
+  }
+
+  void* allocate(std::size_t size, std::size_t align) {
+    if (block_size_ == 0) {
+      block_align_ = std::max(align, alignof(free_block));
+      block_size_ = round_up_(std::max(size, sizeof(free_block)));
+    }
+    precondition(size <= block_size_ && align <= block_align_,
+                 "node_pool only serves a single block size");
+
+    if (!free_list_) {
+      add_slab_();
+    }
+
+    auto* result = free_list_;
+    free_list_ = result->next;
+    return result;
+  }
+
+  void deallocate(void* ptr) noexcept {
+    auto* block = ::new (ptr) free_block{free_list_};
+    free_list_ = block;
+  }
+
+ private:
+  struct free_block {
+    free_block* next;
+  };
+
+  std::size_t round_up_(std::size_t size) const {
+    return (size + block_align_ - 1) / block_align_ * block_align_;
+  }
+
+  void add_slab_() {
+    auto* slab = static_cast<std::byte*>(::operator new(
+        block_size_ * blocks_per_slab_, std::align_val_t{block_align_}));
+    slabs_.push_back(slab);
+
+    for (std::size_t i = blocks_per_slab_; i > 0; --i) {
+      deallocate(slab + (i - 1) * block_size_);
+    }
+  }
+
+  std::size_t blocks_per_slab_;
+  std::size_t block_size_ = 0;
+  std::size_t block_align_ = alignof(free_block);
+  free_block* free_list_ = nullptr;
+  std::vector<std::byte*> slabs_;
+};
+
+// Allocator drawing single objects from a node_pool.
+// usage:
+//   abu::feed::node_pool pool;
+//   abu::feed::stream<Chunk, abu::feed::node_pool_allocator<Chunk>> s{&pool};
+template <typename T>
+class node_pool_allocator {
+ public:
+  using value_type = T;
+
+  node_pool_allocator(node_pool* pool) noexcept : pool_(pool) {}
+
+  template <typename U>
+  node_pool_allocator(const node_pool_allocator<U>& other) noexcept
+      : pool_(other.pool()) {}
+
+  T* allocate(std::size_t n) {
+    precondition(n == 1, "node_pool_allocator only allocates single objects");
+    return static_cast<T*>(pool_->allocate(sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T* ptr, std::size_t) noexcept {
+    pool_->deallocate(ptr);
+  }
+
+  node_pool* pool() const noexcept {
+    return pool_;
+  }
+
+  template <typename U>
+  bool operator==(const node_pool_allocator<U>& rhs) const noexcept {
+    return pool_ == rhs.pool();
+  }
+
+ private:
+  node_pool* pool_;
+};
+
+}  // namespace abu::feed
+
+#endif
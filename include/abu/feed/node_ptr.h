@@ -0,0 +1,155 @@
+// Copyright 2021 Francois Chabot
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ABU_FEED_NODE_PTR_H
+#define ABU_FEED_NODE_PTR_H
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+#include "abu/feed/debug.h"
+
+namespace abu::feed::details_ {
+
+// Intrusive reference to a node of a singly-linked chain.
+//
+// Node must provide:
+//   void add_ref() noexcept;
+//   bool release_ref() noexcept;       // true when that was the last ref.
+//   node_ptr<Node> detach_next() noexcept;
+//   static void destroy(Node*) noexcept;
+//
+// Releasing the last reference to the head of a chain releases the chain
+// iteratively, so that arbitrarily long chains don't exhaust the stack.
+template <typename Node>
+class node_ptr {
+ public:
+  constexpr node_ptr() = default;
+  constexpr node_ptr(std::nullptr_t) {}
+
+  node_ptr(const node_ptr& other) noexcept : ptr_(other.ptr_) {
+    if (ptr_) {
+      ptr_->add_ref();
+    }
+  }
+
+  node_ptr(node_ptr&& other) noexcept
+      : ptr_(std::exchange(other.ptr_, nullptr)) {}
+
+  node_ptr& operator=(const node_ptr& other) noexcept {
+    node_ptr tmp(other);
+    std::swap(ptr_, tmp.ptr_);
+    return *this;
+  }
+
+  node_ptr& operator=(node_ptr&& other) noexcept {
+    node_ptr tmp(std::move(other));
+    std::swap(ptr_, tmp.ptr_);
+    return *this;
+  }
+
+  ~node_ptr() {
+    reset();
+  }
+
+  // Takes ownership of a reference that was already counted.
+  static node_ptr adopt(Node* ptr) noexcept {
+    node_ptr result;
+    result.ptr_ = ptr;
+    return result;
+  }
+
+  // Takes an additional reference to a node that is kept alive elsewhere.
+  static node_ptr share(Node* ptr) noexcept {
+    ptr->add_ref();
+    return adopt(ptr);
+  }
+
+  // Gives up the reference without releasing it.
+  Node* release() noexcept {
+    return std::exchange(ptr_, nullptr);
+  }
+
+  void reset() noexcept {
+    Node* current = std::exchange(ptr_, nullptr);
+    while (current && current->release_ref()) {
+      node_ptr next = current->detach_next();
+      Node::destroy(current);
+      current = std::exchange(next.ptr_, nullptr);
+    }
+  }
+
+  Node* get() const noexcept {
+    return ptr_;
+  }
+
+  Node* operator->() const noexcept {
+    assume(ptr_ != nullptr);
+    return ptr_;
+  }
+
+  Node& operator*() const noexcept {
+    assume(ptr_ != nullptr);
+    return *ptr_;
+  }
+
+  explicit operator bool() const noexcept {
+    return ptr_ != nullptr;
+  }
+
+  friend bool operator==(const node_ptr& lhs, const node_ptr& rhs) noexcept {
+    return lhs.ptr_ == rhs.ptr_;
+  }
+
+  friend bool operator==(const node_ptr& lhs, std::nullptr_t) noexcept {
+    return lhs.ptr_ == nullptr;
+  }
+
+ private:
+  Node* ptr_ = nullptr;
+};
+
+// Allocates a node with the given allocator, and returns the only reference
+// to it.
+template <typename Node, typename Alloc, typename... ArgsT>
+node_ptr<Node> allocate_node(const Alloc& alloc, ArgsT&&... args) {
+  using traits =
+      typename std::allocator_traits<Alloc>::template rebind_traits<Node>;
+  typename traits::allocator_type node_alloc(alloc);
+
+  Node* ptr = traits::allocate(node_alloc, 1);
+  try {
+    std::construct_at(ptr, std::forward<ArgsT>(args)..., alloc);
+  } catch (...) {
+    traits::deallocate(node_alloc, ptr, 1);
+    throw;
+  }
+  return node_ptr<Node>::adopt(ptr);
+}
+
+// Counterpart to allocate_node(), to be used by Node::destroy().
+template <typename Node, typename Alloc>
+void deallocate_node(Node* ptr, const Alloc& alloc) noexcept {
+  using traits =
+      typename std::allocator_traits<Alloc>::template rebind_traits<Node>;
+  typename traits::allocator_type node_alloc(alloc);
+
+  std::destroy_at(ptr);
+  traits::deallocate(node_alloc, ptr, 1);
+}
+
+}  // namespace abu::feed::details_
+
+#endif
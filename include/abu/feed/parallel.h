@@ -0,0 +1,262 @@
+// Copyright 2021 Francois Chabot
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ABU_FEED_PARALLEL_H
+#define ABU_FEED_PARALLEL_H
+
+#include <concepts>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <ranges>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "abu/feed/debug.h"
+#include "abu/feed/forward_range_adaptor.h"
+#include "abu/feed/stream.h"
+#include "abu/feed/tags.h"
+
+// Splitting finished data into segments that can be parsed independently.
+//
+// usage:
+//   auto is_newline = [](char c) { return c == '\n'; };
+//   auto segments = abu::feed::split(data, n_threads, is_newline);
+//   auto total = abu::feed::parse_in_parallel(
+//       segments, count_records, std::size_t{0}, std::plus<>{});
+//
+// Segments start right after an element matching a user predicate, so that
+// they line up with record boundaries. Splitting doesn't copy anything.
+
+namespace abu::feed {
+
+namespace details_ {
+// Scans forward from each of the n - 1 evenly spaced split points to the
+// next boundary, and returns the resulting segments as offsets.
+template <Feed F, typename P>
+std::vector<std::pair<std::size_t, std::size_t>> split_points_(
+    F reader,
+    std::size_t total,
+    std::size_t n,
+    P& is_boundary) {
+  precondition(n > 0);
+
+  std::vector<std::pair<std::size_t, std::size_t>> result;
+  std::size_t start = 0;
+  std::size_t offset = 0;
+  for (std::size_t i = 1; i < n; ++i) {
+    auto target = total / n * i + total % n * i / n;
+    if (target < offset) {
+      // The previous segment already extends past this point.
+      continue;
+    }
+
+    reader.advance(
+        static_cast<std::iter_difference_t<F>>(target - offset));
+    offset = target;
+    while (reader != empty && !std::invoke(is_boundary, *reader)) {
+      ++reader;
+      ++offset;
+    }
+    if (reader == empty) {
+      break;
+    }
+    ++reader;
+    ++offset;
+
+    result.emplace_back(start, offset - start);
+    start = offset;
+  }
+
+  if (start < total) {
+    result.emplace_back(start, total - start);
+  }
+  return result;
+}
+
+template <Chunk ChunkT, typename Alloc>
+auto segment_feed(
+    const stream_rope<ChunkT, Alloc>& segment) {
+  return segment.reader();
+}
+
+template <std::ranges::forward_range R>
+auto segment_feed(const R& segment) {
+  using adaptor_type = forward_range_adaptor<std::ranges::iterator_t<const R>,
+                                             std::ranges::sentinel_t<const R>>;
+  return adaptor_type{std::ranges::begin(segment), std::ranges::end(segment)};
+}
+
+template <typename SegmentT>
+using segment_feed_t =
+    decltype(segment_feed(std::declval<const SegmentT&>()));
+}  // namespace details_
+
+// Splits a rope into at most n segments.
+template <Chunk ChunkT,
+          typename Alloc,
+          std::predicate<const std::ranges::range_value_t<ChunkT>&> P>
+std::vector<stream_rope<ChunkT, Alloc>> split(
+    const stream_rope<ChunkT, Alloc>& data,
+    std::size_t n,
+    P is_boundary) {
+  std::vector<stream_rope<ChunkT, Alloc>> result;
+  for (auto [pos, len] :
+       details_::split_points_(data.reader(), data.size(), n, is_boundary)) {
+    result.push_back(data.subrope(pos, len));
+  }
+  return result;
+}
+
+// Splits what's left of a finished stream into at most n segments, without
+// moving the stream.
+template <Chunk ChunkT,
+          typename Alloc,
+          std::predicate<const std::ranges::range_value_t<ChunkT>&> P>
+std::vector<stream_rope<ChunkT, Alloc>> split(
+    const stream<ChunkT, Alloc>& data,
+    std::size_t n,
+    P is_boundary) requires details_::contiguous_chunk<const ChunkT> {
+  auto cursor = data.cursor();
+  std::size_t total = 0;
+  while (cursor != empty) {
+    auto block = cursor.current_span();
+    total += block.size();
+    cursor.advance(std::ssize(block));
+  }
+  precondition(cursor == end_of_feed,
+               "splitting a stream that isn't finished");
+
+  return split(data.rope(total), n, std::move(is_boundary));
+}
+
+// Splits a range into at most n subranges. Each of them can be read with
+// adapt_range().
+template <std::ranges::forward_range R,
+          std::predicate<const std::ranges::range_value_t<R>&> P>
+requires std::ranges::sized_range<R> && std::ranges::borrowed_range<R>
+std::vector<std::ranges::subrange<std::ranges::iterator_t<R>>> split(
+    R&& data,
+    std::size_t n,
+    P is_boundary) {
+  auto size = static_cast<std::size_t>(std::ranges::size(data));
+  using adaptor_type = forward_range_adaptor<std::ranges::iterator_t<R>,
+                                             std::ranges::sentinel_t<R>>;
+  adaptor_type reader{std::ranges::begin(data), std::ranges::end(data)};
+
+  std::vector<std::ranges::subrange<std::ranges::iterator_t<R>>> result;
+  for (auto [pos, len] :
+       details_::split_points_(reader, size, n, is_boundary)) {
+    auto first = std::ranges::next(std::ranges::begin(data),
+                                   static_cast<std::ptrdiff_t>(pos));
+    auto last = std::ranges::next(first, static_cast<std::ptrdiff_t>(len));
+    result.emplace_back(first, last);
+  }
+  return result;
+}
+
+// Runs consume over a feed of each segment, each on its own thread, and
+// returns the results in the same order as the segments, or nothing if
+// consume returns void.
+//
+// Every thread calls its own copy of consume, so stateful consumers don't
+// race with each other. Whatever the copies refer to is shared, though.
+//
+// The segments must not be modified or destroyed until this returns. If any
+// of the calls throws, the first exception is rethrown once all of them are
+// done.
+template <typename SegmentT, typename ConsumeFn>
+requires std::copy_constructible<ConsumeFn> &&
+    std::invocable<ConsumeFn&, details_::segment_feed_t<SegmentT>&>
+auto parse_in_parallel(const std::vector<SegmentT>& segments,
+                       ConsumeFn consume) {
+  using feed_type = details_::segment_feed_t<SegmentT>;
+  using result_type = std::invoke_result_t<ConsumeFn&, feed_type&>;
+  constexpr bool returns_void = std::is_void_v<result_type>;
+  using stored_type =
+      std::conditional_t<returns_void, std::monostate, result_type>;
+
+  std::vector<std::optional<stored_type>> results(segments.size());
+  std::vector<std::exception_ptr> errors(segments.size());
+
+  auto run = [&](std::size_t i) {
+    try {
+      ConsumeFn local_consume = std::as_const(consume);
+      auto feed = details_::segment_feed(segments[i]);
+      if constexpr (returns_void) {
+        std::invoke(local_consume, feed);
+        results[i].emplace();
+      } else {
+        results[i].emplace(std::invoke(local_consume, feed));
+      }
+    } catch (...) {
+      errors[i] = std::current_exception();
+    }
+  };
+
+  {
+    // Joins whichever workers got started, even if starting the next one
+    // throws.
+    std::vector<std::jthread> workers;
+    workers.reserve(segments.size());
+    for (std::size_t i = 1; i < segments.size(); ++i) {
+      workers.emplace_back(run, i);
+    }
+
+    // The calling thread takes care of the first segment.
+    if (!segments.empty()) {
+      run(0);
+    }
+  }
+
+  for (auto& err : errors) {
+    if (err) {
+      std::rethrow_exception(err);
+    }
+  }
+
+  if constexpr (!returns_void) {
+    std::vector<result_type> values;
+    values.reserve(results.size());
+    for (auto& result : results) {
+      values.push_back(std::move(*result));
+    }
+    return values;
+  }
+}
+
+// Same as above, but folds the results together, in order, starting from
+// init, with merge. Returns init if there are no segments.
+template <typename SegmentT, typename ConsumeFn, typename T, typename MergeFn>
+T parse_in_parallel(const std::vector<SegmentT>& segments,
+                    ConsumeFn consume,
+                    T init,
+                    MergeFn merge) {
+  auto results = parse_in_parallel(segments, std::move(consume));
+
+  auto result = std::move(init);
+  for (auto& value : results) {
+    result = std::invoke(merge, std::move(result), std::move(value));
+  }
+  return result;
+}
+
+}  // namespace abu::feed
+
+#endif
@@ -0,0 +1,384 @@
+// Copyright 2021 Francois Chabot
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ABU_FEED_SCHEDULER_H
+#define ABU_FEED_SCHEDULER_H
+
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "abu/feed/debug.h"
+
+// Resuming the consumers of many streams on a pool of threads.
+//
+// usage:
+//   abu::feed::resume_scheduler scheduler;
+//   auto id = scheduler.add([&] { parser.resume(); });
+//
+//   // Whenever data gets appended to the parser's stream:
+//   scheduler.notify(id);
+//
+//   // The consumer is removed once id is destroyed, or explicitly with:
+//   scheduler.remove(id);
+//
+// Consumers are only resumed once notified, and a consumer never runs on two
+// threads at once. Since producers append while consumers read, streams
+// shared with another thread should be concurrent_streams.
+
+namespace abu::feed {
+
+namespace details_ {
+struct scheduled_consumer {
+  // Low bits.
+  static constexpr unsigned idle = 0;
+  static constexpr unsigned queued = 1;
+  static constexpr unsigned running = 2;
+  // Notified while running, so it has to run again.
+  static constexpr unsigned notified = 3;
+
+  // Set on top of any of the above.
+  static constexpr unsigned removed = 4;
+
+  explicit scheduled_consumer(std::function<void()> in_resume)
+      : resume(std::move(in_resume)) {}
+
+  std::function<void()> resume;
+  std::atomic<unsigned> state = idle;
+};
+
+struct scheduler_worker {
+  const void* scheduler = nullptr;
+  std::size_t index = 0;
+};
+
+// Lets notifications made from within a consumer go to the worker running
+// it.
+inline thread_local scheduler_worker current_scheduler_worker;
+}  // namespace details_
+
+// Runs consumers on a pool of worker threads, whenever they have been
+// notified of new data since they last ran.
+//
+// Each worker has its own queue, which it runs in order, and steals from the
+// back of the others' once it runs dry. Notifying a consumer while it runs
+// gets it queued again once it returns, so no data is left unseen.
+class resume_scheduler {
+  using consumer_type = details_::scheduled_consumer;
+
+ public:
+  // Keeps a consumer registered for as long as it lives.
+  //
+  // The consumer itself is shared with the workers, so that a consumer that
+  // is queued or running when its handle goes away is dropped once they are
+  // done with it rather than left dangling.
+  class handle {
+   public:
+    handle() = default;
+
+    handle(handle&&) noexcept = default;
+
+    handle& operator=(handle&& other) noexcept {
+      if (this != &other) {
+        reset_();
+        consumer_ = std::move(other.consumer_);
+      }
+      return *this;
+    }
+
+    ~handle() {
+      reset_();
+    }
+
+    // Whether the handle still refers to a registered consumer.
+    explicit operator bool() const noexcept {
+      return consumer_ != nullptr;
+    }
+
+   private:
+    friend class resume_scheduler;
+
+    explicit handle(std::shared_ptr<consumer_type> consumer)
+        : consumer_(std::move(consumer)) {}
+
+    void reset_() noexcept {
+      if (consumer_) {
+        consumer_->state.fetch_or(consumer_type::removed,
+                                  std::memory_order_acq_rel);
+        consumer_.reset();
+      }
+    }
+
+    std::shared_ptr<consumer_type> consumer_;
+  };
+
+  explicit resume_scheduler(
+      std::size_t thread_count =
+          std::max(std::thread::hardware_concurrency(), 1u))
+      : queues_(thread_count) {
+    precondition(thread_count > 0);
+
+    workers_.reserve(thread_count);
+    for (std::size_t i = 0; i < thread_count; ++i) {
+      workers_.emplace_back([this, i] { work_(i); });
+    }
+  }
+
+  resume_scheduler(const resume_scheduler&) = delete;
+  resume_scheduler& operator=(const resume_scheduler&) = delete;
+
+  // Consumers that are still queued are dropped without running. Handles can
+  // outlive the scheduler.
+  ~resume_scheduler() {
+    {
+      std::lock_guard lock{sleep_mutex_};
+      stopping_.store(true);
+    }
+    wake_.notify_all();
+
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  // Registers a consumer, which starts out idle.
+  template <std::invocable<> Fn>
+  [[nodiscard]] handle add(Fn resume) {
+    return handle{std::make_shared<consumer_type>(
+        std::function<void()>{std::move(resume)})};
+  }
+
+  // Lets the scheduler know that the consumer has something new to read.
+  // Can be called from any thread, including from within consumers, as long
+  // as the handle isn't removed or destroyed concurrently.
+  void notify(const handle& id) {
+    precondition(id.consumer_ != nullptr, "notifying a removed consumer");
+
+    auto& consumer = *id.consumer_;
+    auto state = consumer.state.load(std::memory_order_acquire);
+    while (true) {
+      unsigned next = 0;
+      switch (state) {
+        case consumer_type::idle:
+          next = consumer_type::queued;
+          break;
+        case consumer_type::running:
+          next = consumer_type::notified;
+          break;
+        default:
+          // Already going to run, or removed.
+          return;
+      }
+
+      if (consumer.state.compare_exchange_weak(
+              state, next, std::memory_order_acq_rel)) {
+        break;
+      }
+    }
+
+    if (state == consumer_type::idle) {
+      pending_.fetch_add(1, std::memory_order_relaxed);
+      enqueue_(id.consumer_);
+    }
+  }
+
+  // Unregisters a consumer ahead of the destruction of its handle, which is
+  // left empty. If it is running, this does not wait for it to return.
+  void remove(handle& id) {
+    precondition(id.consumer_ != nullptr, "removing a consumer twice");
+    id.reset_();
+  }
+
+  // Blocks until no consumer is queued or running. If any of them threw
+  // since the last call, the first exception is rethrown.
+  void wait_idle() {
+    std::unique_lock lock{idle_mutex_};
+    idle_.wait(lock, [&] {
+      return pending_.load(std::memory_order_acquire) == 0;
+    });
+
+    if (error_) {
+      std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+  }
+
+  std::size_t thread_count() const {
+    return workers_.size();
+  }
+
+ private:
+  using consumer_ptr = std::shared_ptr<consumer_type>;
+
+  struct alignas(64) worker_queue {
+    std::mutex mutex;
+    std::deque<consumer_ptr> consumers;
+  };
+
+  void enqueue_(consumer_ptr consumer) {
+    auto& worker = details_::current_scheduler_worker;
+    auto index = worker.scheduler == this
+                     ? worker.index
+                     : next_queue_.fetch_add(1, std::memory_order_relaxed) %
+                           queues_.size();
+
+    queued_.fetch_add(1);
+    {
+      auto& queue = queues_[index];
+      std::lock_guard lock{queue.mutex};
+      queue.consumers.push_back(std::move(consumer));
+    }
+
+    // Pairs with the check in work_(), so that a worker either sees the
+    // consumer or gets woken up.
+    if (sleeping_.load() > 0) {
+      { std::lock_guard lock{sleep_mutex_}; }
+      wake_.notify_one();
+    }
+  }
+
+  consumer_ptr dequeue_(std::size_t index) {
+    if (queued_.load() == 0) {
+      return nullptr;
+    }
+
+    for (std::size_t i = 0; i < queues_.size(); ++i) {
+      auto& queue = queues_[(index + i) % queues_.size()];
+      std::lock_guard lock{queue.mutex};
+      if (queue.consumers.empty()) {
+        continue;
+      }
+
+      consumer_ptr result;
+      if (i == 0) {
+        result = std::move(queue.consumers.front());
+        queue.consumers.pop_front();
+      } else {
+        result = std::move(queue.consumers.back());
+        queue.consumers.pop_back();
+      }
+      queued_.fetch_sub(1);
+      return result;
+    }
+    return nullptr;
+  }
+
+  void work_(std::size_t index) {
+    details_::current_scheduler_worker = {this, index};
+
+    while (!stopping_.load()) {
+      if (auto consumer = dequeue_(index)) {
+        run_(std::move(consumer));
+        continue;
+      }
+
+      std::unique_lock lock{sleep_mutex_};
+      sleeping_.fetch_add(1);
+      wake_.wait(lock, [&] { return queued_.load() > 0 || stopping_.load(); });
+      sleeping_.fetch_sub(1);
+    }
+  }
+
+  void run_(consumer_ptr consumer) {
+    auto state = consumer->state.load(std::memory_order_acquire);
+    while (true) {
+      if (state & consumer_type::removed) {
+        done_();
+        return;
+      }
+
+      switch (state) {
+        case consumer_type::queued:
+          if (!consumer->state.compare_exchange_weak(
+                  state, consumer_type::running, std::memory_order_acq_rel)) {
+            continue;
+          }
+          resume_(*consumer);
+          state = consumer->state.load(std::memory_order_acquire);
+          break;
+
+        case consumer_type::running:
+          if (consumer->state.compare_exchange_weak(
+                  state, consumer_type::idle, std::memory_order_acq_rel)) {
+            done_();
+            return;
+          }
+          break;
+
+        case consumer_type::notified:
+          // Goes to the back of the queue rather than running right away, so
+          // that busy consumers don't starve the others.
+          if (consumer->state.compare_exchange_weak(
+                  state, consumer_type::queued, std::memory_order_acq_rel)) {
+            enqueue_(std::move(consumer));
+            return;
+          }
+          break;
+
+        default:
+          assume(false);
+          return;
+      }
+    }
+  }
+
+  void resume_(consumer_type& consumer) {
+    try {
+      consumer.resume();
+    } catch (...) {
+      std::lock_guard lock{idle_mutex_};
+      if (!error_) {
+        error_ = std::current_exception();
+      }
+    }
+  }
+
+  // A consumer stopped being queued or running.
+  void done_() {
+    if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      std::lock_guard lock{idle_mutex_};
+      idle_.notify_all();
+    }
+  }
+
+  std::vector<worker_queue> queues_;
+  std::atomic<std::size_t> next_queue_ = 0;
+  std::atomic<std::size_t> queued_ = 0;
+
+  std::mutex sleep_mutex_;
+  std::condition_variable wake_;
+  std::atomic<std::size_t> sleeping_ = 0;
+  std::atomic<bool> stopping_ = false;
+
+  // How many consumers are queued or running.
+  std::atomic<std::size_t> pending_ = 0;
+  std::mutex idle_mutex_;
+  std::condition_variable idle_;
+  std::exception_ptr error_;
+
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace abu::feed
+
+#endif
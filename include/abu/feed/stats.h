@@ -0,0 +1,278 @@
+// Copyright 2021 Francois Chabot
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ABU_FEED_STATS_H
+#define ABU_FEED_STATS_H
+
+#include <cstddef>
+#include <iterator>
+#include <ranges>
+#include <set>
+#include <type_traits>
+#include <utility>
+
+#include "abu/mem.h"
+
+// Streams only keep track of the following statistics when
+// ABU_FEED_COLLECT_STATS is set. Otherwise, all of the bookkeeping compiles
+// down to nothing.
+//
+// This changes the layout of streams, so it must be set consistently across
+// the whole program. Linking against abu::instrumented::feed takes care of
+// that.
+#ifndef ABU_FEED_COLLECT_STATS
+#define ABU_FEED_COLLECT_STATS false
+#endif
+
+namespace abu::feed {
+
+struct stream_stats {
+  // Chunks and elements kept alive, by the stream itself or by checkpoints.
+  std::size_t retained_chunks = 0;
+  std::size_t retained_elements = 0;
+
+  // Scoped checkpoints are not counted.
+  std::size_t live_checkpoints = 0;
+
+  // How many elements the stream is past its oldest live checkpoint.
+  std::size_t oldest_checkpoint_age = 0;
+
+  // Every element moved past, including the ones read again after a rollback.
+  std::size_t elements_consumed = 0;
+  std::size_t chunk_transitions = 0;
+
+  std::size_t rollbacks = 0;
+  // Total number of elements that rollbacks moved back by.
+  std::size_t rollback_distance = 0;
+};
+
+namespace details_ {
+inline constexpr bool collect_stats = ABU_FEED_COLLECT_STATS;
+
+struct stats_state {
+  stream_stats counters;
+  std::size_t position = 0;
+  std::multiset<std::size_t> checkpoints;
+};
+
+class counting_node_stats {
+ public:
+  counting_node_stats() = default;
+  counting_node_stats(mem::ref_count_ptr<stats_state> state,
+                      std::size_t elements)
+      : state_(std::move(state)), elements_(elements) {
+    state_->counters.retained_chunks += 1;
+    state_->counters.retained_elements += elements_;
+  }
+
+  counting_node_stats(counting_node_stats&& other)
+      : state_(std::exchange(other.state_, nullptr)),
+        elements_(other.elements_) {}
+
+  counting_node_stats(const counting_node_stats&) = delete;
+  counting_node_stats& operator=(const counting_node_stats&) = delete;
+
+  ~counting_node_stats() {
+    if (state_ != nullptr) {
+      state_->counters.retained_chunks -= 1;
+      state_->counters.retained_elements -= elements_;
+    }
+  }
+
+  // Catches up with a chunk that grew in place.
+  template <std::ranges::range ChunkT>
+  void refresh(const ChunkT& chunk) {
+    if (state_ != nullptr) {
+      auto elements = static_cast<std::size_t>(std::ranges::distance(chunk));
+      state_->counters.retained_elements += elements - elements_;
+      elements_ = elements;
+    }
+  }
+
+ private:
+  mem::ref_count_ptr<stats_state> state_;
+  std::size_t elements_ = 0;
+};
+
+class counting_checkpoint_stats {
+ public:
+  counting_checkpoint_stats(mem::ref_count_ptr<stats_state> state)
+      : state_(std::move(state)), position_(state_->position) {
+    acquire_();
+  }
+
+  counting_checkpoint_stats(const counting_checkpoint_stats& other)
+      : state_(other.state_), position_(other.position_) {
+    acquire_();
+  }
+
+  counting_checkpoint_stats(counting_checkpoint_stats&& other)
+      : state_(std::exchange(other.state_, nullptr)),
+        position_(other.position_) {}
+
+  counting_checkpoint_stats& operator=(const counting_checkpoint_stats& other) {
+    if (this != &other) {
+      release_();
+      state_ = other.state_;
+      position_ = other.position_;
+      acquire_();
+    }
+    return *this;
+  }
+
+  counting_checkpoint_stats& operator=(counting_checkpoint_stats&& other) {
+    if (this != &other) {
+      release_();
+      state_ = std::exchange(other.state_, nullptr);
+      position_ = other.position_;
+    }
+    return *this;
+  }
+
+  ~counting_checkpoint_stats() {
+    release_();
+  }
+
+  std::size_t position() const {
+    return position_;
+  }
+
+ private:
+  void acquire_() {
+    if (state_ != nullptr) {
+      state_->checkpoints.insert(position_);
+    }
+  }
+
+  void release_() {
+    if (state_ != nullptr) {
+      state_->checkpoints.erase(state_->checkpoints.find(position_));
+    }
+  }
+
+  mem::ref_count_ptr<stats_state> state_;
+  std::size_t position_;
+};
+
+struct counting_scoped_checkpoint_stats {
+  std::size_t position;
+};
+
+class counting_stats_recorder {
+ public:
+  using node_stats = counting_node_stats;
+  using checkpoint_stats = counting_checkpoint_stats;
+  using scoped_checkpoint_stats = counting_scoped_checkpoint_stats;
+
+  counting_stats_recorder() : state_(mem::make_ref_counted<stats_state>()) {}
+
+  template <std::ranges::range ChunkT>
+  node_stats track_node(const ChunkT& chunk) {
+    auto elements = static_cast<std::size_t>(std::ranges::distance(chunk));
+    return {state_, elements};
+  }
+
+  void consumed(std::ptrdiff_t n) {
+    state_->counters.elements_consumed += static_cast<std::size_t>(n);
+    state_->position += static_cast<std::size_t>(n);
+  }
+
+  void chunk_transition() {
+    state_->counters.chunk_transitions += 1;
+  }
+
+  checkpoint_stats checkpoint() {
+    return {state_};
+  }
+
+  scoped_checkpoint_stats scoped_checkpoint() const {
+    return {state_->position};
+  }
+
+  void rollback(const checkpoint_stats& cp) {
+    rollback_to_(cp.position());
+  }
+
+  void rollback(const scoped_checkpoint_stats& cp) {
+    rollback_to_(cp.position);
+  }
+
+  stream_stats snapshot() const {
+    stream_stats result = state_->counters;
+    result.live_checkpoints = state_->checkpoints.size();
+    // After a rollback, the stream can be behind its checkpoints.
+    if (!state_->checkpoints.empty() &&
+        *state_->checkpoints.begin() < state_->position) {
+      result.oldest_checkpoint_age =
+          state_->position - *state_->checkpoints.begin();
+    }
+    return result;
+  }
+
+ private:
+  void rollback_to_(std::size_t position) {
+    state_->counters.rollbacks += 1;
+    if (position < state_->position) {
+      state_->counters.rollback_distance += state_->position - position;
+    }
+    state_->position = position;
+  }
+
+  mem::ref_count_ptr<stats_state> state_;
+};
+
+struct null_node_stats {
+  template <typename ChunkT>
+  constexpr void refresh(const ChunkT&) {}
+};
+
+struct null_checkpoint_stats {};
+struct null_scoped_checkpoint_stats {};
+
+struct null_stats_recorder {
+  using node_stats = null_node_stats;
+  using checkpoint_stats = null_checkpoint_stats;
+  using scoped_checkpoint_stats = null_scoped_checkpoint_stats;
+
+  template <typename ChunkT>
+  constexpr node_stats track_node(const ChunkT&) {
+    return {};
+  }
+
+  constexpr void consumed(std::ptrdiff_t) {}
+  constexpr void chunk_transition() {}
+
+  constexpr checkpoint_stats checkpoint() {
+    return {};
+  }
+
+  constexpr scoped_checkpoint_stats scoped_checkpoint() const {
+    return {};
+  }
+
+  constexpr void rollback(const checkpoint_stats&) {}
+  constexpr void rollback(const scoped_checkpoint_stats&) {}
+
+  constexpr stream_stats snapshot() const {
+    return {};
+  }
+};
+
+using stats_recorder = std::conditional_t<collect_stats,
+                                          counting_stats_recorder,
+                                          null_stats_recorder>;
+}  // namespace details_
+}  // namespace abu::feed
+
+#endif
@@ -15,41 +15,96 @@
 #ifndef ABU_FEED_STREAM_H
 #define ABU_FEED_STREAM_H
 
+#include <algorithm>
+#include <concepts>
+#include <iterator>
+#include <memory>
 #include <optional>
 #include <ranges>
+#include <span>
 
 #include "abu/feed/debug.h"
+#include "abu/feed/location.h"
+#include "abu/feed/lookahead.h"
+#include "abu/feed/node_ptr.h"
+#include "abu/feed/stats.h"
 #include "abu/feed/tags.h"
-#include "abu/mem.h"
 
 namespace abu::feed {
 
 template <typename T>
 concept Chunk = std::ranges::forward_range<T>;
 
-template <Chunk ChunkT>
+template <Chunk ChunkT, typename Alloc = std::allocator<ChunkT>>
 class stream;
 
+template <Chunk ChunkT, typename Alloc>
+class stream_cursor;
+
+template <Chunk ChunkT, typename Alloc>
+class rope_reader;
+
 namespace details_ {
-template <Chunk ChunkT>
+template <typename T>
+concept contiguous_chunk =
+    std::ranges::contiguous_range<T> && std::ranges::sized_range<T>;
+
+template <typename T>
+struct pointer_bounds {
+  const T* begin = nullptr;
+  const T* end = nullptr;
+};
+
+struct no_bounds {};
+
+template <Chunk ChunkT, typename Alloc>
 struct stream_node {
   static_assert(std::is_const_v<ChunkT>);
 
-  stream_node() = default;
-  stream_node(ChunkT&& in_data) : data_(std::move(in_data)) {}
+  // Contiguous chunks are reduced to a pair of pointers once and for all, so
+  // that the stream never has to go through the optional, or through the
+  // chunk's own iterators.
+  static constexpr bool is_contiguous = contiguous_chunk<ChunkT>;
 
-  std::ranges::iterator_t<ChunkT> begin() const {
-    if (data_) {
-      return std::ranges::begin(*data_);
+  using value_type = std::ranges::range_value_t<ChunkT>;
+  using iterator = std::conditional_t<is_contiguous,
+                                      const value_type*,
+                                      std::ranges::iterator_t<ChunkT>>;
+  using sentinel = std::conditional_t<is_contiguous,
+                                      const value_type*,
+                                      std::ranges::sentinel_t<ChunkT>>;
+  using bounds_type =
+      std::conditional_t<is_contiguous, pointer_bounds<value_type>, no_bounds>;
+  using node_stats = stats_recorder::node_stats;
+
+  explicit stream_node(const Alloc& alloc) : alloc_(alloc) {}
+  stream_node(std::remove_const_t<ChunkT>&& in_data,
+              node_stats stats,
+              const Alloc& alloc)
+      : data_(std::move(in_data)), stats_(std::move(stats)), alloc_(alloc) {
+    update_bounds_();
+  }
+
+  iterator begin() const {
+    if constexpr (is_contiguous) {
+      return bounds_.begin;
+    } else {
+      if (data_) {
+        return std::ranges::begin(*data_);
+      }
+      return {};
     }
-    return {};
   }
 
-  std::ranges::sentinel_t<ChunkT> end() const {
-    if (data_) {
-      return std::ranges::end(*data_);
+  sentinel end() const {
+    if constexpr (is_contiguous) {
+      return bounds_.end;
+    } else {
+      if (data_) {
+        return std::ranges::end(*data_);
+      }
+      return {};
     }
-    return {};
   }
 
   void mark_final() {
@@ -61,51 +116,415 @@ struct stream_node {
     return is_final_;
   }
 
-  void set_next(mem::ref_count_ptr<stream_node<ChunkT>> next) {
+  void set_next(node_ptr<stream_node> next) {
     assume(!next_ && !is_final_);
-    next_ = next;
+    next_ = std::move(next);
   }
 
-  const mem::ref_count_ptr<stream_node<ChunkT>>& next() const {
+  const node_ptr<stream_node>& next() const {
     return next_;
   }
 
+  const Alloc& get_allocator() const {
+    return alloc_;
+  }
+
+  // Where the first element of the chunk sits in the stream.
+  const location& origin() const {
+    return origin_;
+  }
+
+  void set_origin(const location& origin) {
+    origin_ = origin;
+  }
+
+  // To be called when data_ grew in place.
+  void refresh() {
+    if (data_) {
+      update_bounds_();
+      stats_.refresh(*data_);
+    }
+  }
+
+  // node_ptr interface
+  void add_ref() noexcept {
+    ++ref_count_;
+  }
+
+  bool release_ref() noexcept {
+    return --ref_count_ == 0;
+  }
+
+  node_ptr<stream_node> detach_next() noexcept {
+    return std::move(next_);
+  }
+
+  static void destroy(stream_node* node) noexcept {
+    deallocate_node(node, node->alloc_);
+  }
+
  private:
-  mem::ref_count_ptr<stream_node<ChunkT>> next_;
+  void update_bounds_() {
+    if constexpr (is_contiguous) {
+      bounds_.begin = std::ranges::data(*data_);
+      bounds_.end = bounds_.begin + std::ranges::size(*data_);
+    }
+  }
+
+  std::size_t ref_count_ = 1;
+  node_ptr<stream_node> next_;
   bool is_final_ = false;
+  location origin_;
   std::optional<ChunkT> data_;
+  [[no_unique_address]] bounds_type bounds_;
+  [[no_unique_address]] node_stats stats_;
+  [[no_unique_address]] Alloc alloc_;
 };
 
-template <Chunk ChunkT>
+template <Chunk ChunkT, typename Alloc>
 struct stream_checkpoint {
  private:
-  friend class stream<ChunkT>;
+  friend class stream<ChunkT, Alloc>;
+
+  using node_type = stream_node<const ChunkT, Alloc>;
+
+  using checkpoint_stats = stats_recorder::checkpoint_stats;
+
+  stream_checkpoint(typename node_type::iterator pos,
+                    node_ptr<node_type> chunk,
+                    checkpoint_stats stats)
+      : position_(std::move(pos)),
+        current_chunk_(std::move(chunk)),
+        stats_(std::move(stats)) {}
+
+  typename node_type::iterator position_;
+  node_ptr<node_type> current_chunk_;
+  [[no_unique_address]] checkpoint_stats stats_;
+};
 
-  stream_checkpoint(std::ranges::iterator_t<const ChunkT> pos,
-                    mem::ref_count_ptr<stream_node<const ChunkT>> chunk)
+// Does not own its chunk: it's only valid within the retention_scope it was
+// taken in.
+template <Chunk ChunkT, typename Alloc>
+struct stream_scoped_checkpoint {
+ private:
+  friend class stream<ChunkT, Alloc>;
+
+  using node_type = stream_node<const ChunkT, Alloc>;
+  using checkpoint_stats = stats_recorder::scoped_checkpoint_stats;
+
+  stream_scoped_checkpoint(typename node_type::iterator pos,
+                           node_type* chunk,
+                           std::size_t scope_id,
+                           checkpoint_stats stats)
+      : position_(std::move(pos)),
+        current_chunk_(chunk),
+        scope_id_(scope_id),
+        stats_(stats) {}
+
+  typename node_type::iterator position_;
+  node_type* current_chunk_;
+  std::size_t scope_id_;
+  [[no_unique_address]] checkpoint_stats stats_;
+};
+
+template <Chunk ChunkT, typename Alloc>
+struct stream_cursor_checkpoint {
+ private:
+  friend class stream_cursor<ChunkT, Alloc>;
+
+  using node_type = stream_node<const ChunkT, Alloc>;
+
+  stream_cursor_checkpoint(typename node_type::iterator pos,
+                           node_ptr<node_type> chunk)
       : position_(std::move(pos)), current_chunk_(std::move(chunk)) {}
 
-  std::ranges::iterator_t<const ChunkT> position_;
-  mem::ref_count_ptr<stream_node<const ChunkT>> current_chunk_;
+  typename node_type::iterator position_;
+  node_ptr<node_type> current_chunk_;
 };
 }  // namespace details_
 
-template <Chunk ChunkT>
+// A run of consecutive elements of a stream, which keeps the chunks holding
+// them alive on its own.
+//
+// usage:
+//   auto header = feed.rope(16);
+//   feed.advance(16);
+//   for (std::span<const char> piece : header.pieces()) { ... }
+template <Chunk ChunkT, typename Alloc>
+class stream_rope {
+ public:
+  using node_type = details_::stream_node<const ChunkT, Alloc>;
+  using value_type = std::ranges::range_value_t<ChunkT>;
+  using piece_type = std::span<const value_type>;
+  using reader_type = rope_reader<ChunkT, Alloc>;
+
+  // Walks the rope one chunk at a time.
+  class piece_iterator {
+   public:
+    using value_type = piece_type;
+    using difference_type = std::ptrdiff_t;
+
+    piece_iterator() = default;
+
+    piece_type operator*() const {
+      auto in_node = static_cast<std::size_t>(node_->end() - pos_);
+      return {pos_, std::min(remaining_, in_node)};
+    }
+
+    piece_iterator& operator++() {
+      remaining_ -= (**this).size();
+      node_ = node_->next().get();
+      pos_ = node_ ? node_->begin() : nullptr;
+      return *this;
+    }
+
+    piece_iterator operator++(int) {
+      auto result = *this;
+      ++(*this);
+      return result;
+    }
+
+    bool operator==(const piece_iterator&) const = default;
+
+    bool operator==(std::default_sentinel_t) const {
+      return remaining_ == 0;
+    }
+
+   private:
+    friend class stream_rope;
+
+    piece_iterator(const node_type* node,
+                   const typename stream_rope::value_type* pos,
+                   std::size_t remaining)
+        : node_(node), pos_(pos), remaining_(remaining) {}
+
+    const node_type* node_ = nullptr;
+    const typename stream_rope::value_type* pos_ = nullptr;
+    std::size_t remaining_ = 0;
+  };
+
+  stream_rope() = default;
+
+  std::size_t size() const {
+    return size_;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  // Whether all of the elements sit in a single chunk.
+  bool is_contiguous() const {
+    return size_ == 0 ||
+           static_cast<std::size_t>(head_->end() - begin_) >= size_;
+  }
+
+  // Only available when is_contiguous().
+  piece_type span() const {
+    precondition(is_contiguous(), "rope spans multiple chunks");
+    return {begin_, size_};
+  }
+
+  std::ranges::subrange<piece_iterator, std::default_sentinel_t> pieces()
+      const {
+    return {piece_iterator{head_.get(), begin_, size_}, std::default_sentinel};
+  }
+
+  // Returns the n elements starting pos elements into the rope.
+  stream_rope subrope(std::size_t pos, std::size_t n) const {
+    precondition(pos <= size_ && n <= size_ - pos);
+    if (n == 0) {
+      return {};
+    }
+
+    auto* node = head_.get();
+    auto* begin = begin_;
+    while (static_cast<std::size_t>(node->end() - begin) <= pos) {
+      pos -= static_cast<std::size_t>(node->end() - begin);
+      node = node->next().get();
+      begin = node->begin();
+    }
+    return stream_rope{
+        details_::node_ptr<node_type>::share(node), begin + pos, n};
+  }
+
+  // Reads the rope as a feed, which must not outlive it.
+  reader_type reader() const {
+    return reader_type{*this};
+  }
+
+  template <std::output_iterator<const value_type&> O>
+  O copy_to(O out) const {
+    for (auto piece : pieces()) {
+      out = std::ranges::copy(piece, std::move(out)).out;
+    }
+    return out;
+  }
+
+  // Returns the elements as a single span. They are only copied, into
+  // buffer, when they span multiple chunks.
+  // usage:
+  //   std::string scratch;
+  //   auto token = rope.materialize(scratch);
+  template <typename Buffer>
+  requires requires(Buffer& b, std::size_t n) {
+    b.resize(n);
+    { std::ranges::data(b) } -> std::same_as<value_type*>;
+  }
+  piece_type materialize(Buffer& buffer) const {
+    if (is_contiguous()) {
+      return span();
+    }
+
+    buffer.resize(size_);
+    copy_to(std::ranges::data(buffer));
+    return {std::ranges::data(buffer), size_};
+  }
+
+ private:
+  friend class stream<ChunkT, Alloc>;
+
+  stream_rope(details_::node_ptr<node_type> head,
+              const value_type* begin,
+              std::size_t size)
+      : head_(std::move(head)), begin_(begin), size_(size) {}
+
+  details_::node_ptr<node_type> head_;
+  const value_type* begin_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+// A feed over the elements of a rope.
+//
+// Readers never touch the reference counts of the chunks, so different
+// threads can read ropes sharing chunks at the same time, as long as the
+// ropes themselves stay put.
+template <Chunk ChunkT, typename Alloc>
+class rope_reader {
+  using rope_type = stream_rope<ChunkT, Alloc>;
+  using piece_iterator = typename rope_type::piece_iterator;
+
+ public:
+  using iterator_tag = std::input_iterator_tag;
+  using difference_type = std::ptrdiff_t;
+  using value_type = typename rope_type::value_type;
+
+  class checkpoint_type {
+   private:
+    friend class rope_reader;
+
+    checkpoint_type(piece_iterator pieces,
+                    const value_type* pos,
+                    const value_type* end)
+        : pieces_(pieces), pos_(pos), end_(end) {}
+
+    piece_iterator pieces_;
+    const value_type* pos_;
+    const value_type* end_;
+  };
+
+  explicit rope_reader(const rope_type& rope)
+      : pieces_(rope.pieces().begin()) {
+    load_piece_();
+  }
+
+  const value_type& operator*() const {
+    precondition(pos_ != end_);
+    return *pos_;
+  }
+
+  rope_reader& operator++() {
+    precondition(pos_ != end_);
+    if (++pos_ == end_) {
+      load_piece_();
+    }
+    return *this;
+  }
+
+  void operator++(int) {
+    ++(*this);
+  }
+
+  // Ropes are complete, so running out of data is the end of the feed.
+  bool operator==(const empty_feed_t&) const {
+    return pos_ == end_;
+  }
+
+  bool operator==(const end_of_feed_t&) const {
+    return pos_ == end_;
+  }
+
+  std::span<const value_type> current_span() const {
+    return {pos_, end_};
+  }
+
+  void advance(difference_type n) {
+    precondition(n >= 0);
+
+    while (n > 0) {
+      precondition(pos_ != end_, "advancing past the available data");
+
+      auto step = std::min(n, end_ - pos_);
+      pos_ += step;
+      n -= step;
+      if (pos_ == end_) {
+        load_piece_();
+      }
+    }
+  }
+
+  checkpoint_type checkpoint() const {
+    return {pieces_, pos_, end_};
+  }
+
+  void rollback(checkpoint_type cp) {
+    pieces_ = cp.pieces_;
+    pos_ = cp.pos_;
+    end_ = cp.end_;
+  }
+
+ private:
+  void load_piece_() {
+    if (pieces_ != std::default_sentinel) {
+      auto piece = *pieces_++;
+      pos_ = piece.data();
+      end_ = pos_ + piece.size();
+    }
+  }
+
+  piece_iterator pieces_;
+  const value_type* pos_ = nullptr;
+  const value_type* end_ = nullptr;
+};
+
+// Presents a sequence of chunks as a feed.
+//
+// Nodes holding the chunks are allocated through Alloc, which makes it
+// possible to keep them out of the global allocator, for example with a
+// std::pmr::polymorphic_allocator backed by a pool resource.
+template <Chunk ChunkT, typename Alloc>
 class stream {
   static constexpr const char* moved_err_msg =
       "Using stream feed that was moved";
 
  public:
   using chunk_type = const ChunkT;
-  using node_type = details_::stream_node<chunk_type>;
-  using checkpoint_type = details_::stream_checkpoint<ChunkT>;
+  using allocator_type = Alloc;
+  using node_type = details_::stream_node<chunk_type, Alloc>;
+  using checkpoint_type = details_::stream_checkpoint<ChunkT, Alloc>;
+  using scoped_checkpoint_type =
+      details_::stream_scoped_checkpoint<ChunkT, Alloc>;
+  using cursor_type = stream_cursor<ChunkT, Alloc>;
+  using rope_type = stream_rope<ChunkT, Alloc>;
 
   using iterator_tag = std::input_iterator_tag;
   using difference_type = std::ptrdiff_t;
   using value_type = std::ranges::range_value_t<ChunkT>;
 
-  stream() {
-    start_chunk_(mem::make_ref_counted<node_type>());
+  stream() : stream(Alloc()) {}
+
+  explicit stream(const Alloc& alloc) {
+    start_chunk_(details_::allocate_node<node_type>(alloc));
     tail_ = current_chunk_;
   }
 
@@ -127,8 +546,9 @@ class stream {
     precondition(position_ != chunk_end_ || !current_chunk_->is_final());
 
     ++position_;
+    stats_.consumed(1);
     if (position_ == chunk_end_ && !at_last_chunk_()) {
-      start_chunk_(current_chunk_->next());
+      next_chunk_();
     }
     return *this;
   }
@@ -148,7 +568,118 @@ class stream {
     return position_ == chunk_end_ && current_chunk_->is_final();
   }
 
-  void append(chunk_type&& chunk) {
+  // Returns the unread remainder of the current chunk.
+  // usage:
+  //   auto data = feed.current_span();
+  //   ... process data in bulk ...
+  //   feed.advance(data.size());
+  std::span<const value_type> current_span() const
+      requires std::ranges::contiguous_range<chunk_type> {
+    precondition(!is_moved_(), moved_err_msg);
+
+    auto remaining = std::ranges::distance(position_, chunk_end_);
+    return {std::to_address(position_), static_cast<std::size_t>(remaining)};
+  }
+
+  // Skips n elements, which must all be currently available.
+  void advance(difference_type n) {
+    precondition(!is_moved_(), moved_err_msg);
+    precondition(n >= 0);
+
+    stats_.consumed(n);
+    n = std::ranges::advance(position_, n, chunk_end_);
+    while (position_ == chunk_end_ && !at_last_chunk_()) {
+      next_chunk_();
+      n = std::ranges::advance(position_, n, chunk_end_);
+    }
+
+    precondition(n == 0, "advancing past the available data");
+  }
+
+  // Looks at the next n elements without moving the stream.
+  // usage:
+  //   auto next = feed.peek(2);
+  //   if (next.ok() && next[0] == '\r' && next[1] == '\n') { ... }
+  template <std::size_t MaxN = default_max_peek>
+  peek_result<value_type, MaxN> peek(std::size_t n) const
+      requires details_::contiguous_chunk<chunk_type> {
+    precondition(!is_moved_(), moved_err_msg);
+    precondition(n <= MaxN);
+
+    auto here = current_span();
+    if (here.size() >= n) {
+      return peek_result<value_type, MaxN>::viewing(peek_status::ok,
+                                                     here.first(n));
+    }
+
+    // Stitches the following chunks together.
+    std::array<value_type, MaxN> buffer;
+    auto out = std::ranges::copy(here, buffer.begin()).out;
+    auto wanted = n - here.size();
+    for (auto* node = current_chunk_->next().get(); node && wanted > 0;
+         node = node->next().get()) {
+      auto len = std::min(wanted, static_cast<std::size_t>(node->end() -
+                                                           node->begin()));
+      out = std::ranges::copy(node->begin(), node->begin() + len, out).out;
+      wanted -= len;
+    }
+
+    auto status = peek_status::ok;
+    if (wanted > 0) {
+      status = tail_->is_final() ? peek_status::finished
+                                 : peek_status::need_more;
+    }
+    return peek_result<value_type, MaxN>::copying(
+        status, std::span{buffer}.first(n - wanted));
+  }
+
+  // Checks whether the upcoming elements are prefix, without moving the
+  // stream.
+  match_status matches(std::span<const value_type> prefix) const
+      requires details_::contiguous_chunk<chunk_type> {
+    precondition(!is_moved_(), moved_err_msg);
+
+    auto here = current_span();
+    if (here.size() >= prefix.size()) {
+      return std::ranges::equal(here.first(prefix.size()), prefix)
+                 ? match_status::match
+                 : match_status::mismatch;
+    }
+
+    if (!std::ranges::equal(here, prefix.first(here.size()))) {
+      return match_status::mismatch;
+    }
+    prefix = prefix.subspan(here.size());
+
+    for (auto* node = current_chunk_->next().get(); node;
+         node = node->next().get()) {
+      auto data = std::span<const value_type>{node->begin(), node->end()};
+      auto len = std::min(data.size(), prefix.size());
+      if (!std::ranges::equal(data.first(len), prefix.first(len))) {
+        return match_status::mismatch;
+      }
+
+      prefix = prefix.subspan(len);
+      if (prefix.empty()) {
+        return match_status::match;
+      }
+    }
+
+    return tail_->is_final() ? match_status::mismatch
+                             : match_status::need_more;
+  }
+
+  // Returns the next n elements, which must all be available, without moving
+  // the stream.
+  rope_type rope(std::size_t n) const
+      requires details_::contiguous_chunk<chunk_type> {
+    precondition(!is_moved_(), moved_err_msg);
+    precondition(is_available_(n), "roping past the available data");
+
+    return rope_type{current_chunk_, position_, n};
+  }
+
+  void append(ChunkT&& chunk) {
     precondition(!is_moved_(), moved_err_msg);
     precondition(!tail_->is_final());
 
@@ -156,10 +687,15 @@ class stream {
       return;
     }
 
-    auto new_node = mem::make_ref_counted<details_::stream_node<chunk_type>>(
-        std::move(chunk));
+    auto node_stats = stats_.track_node(chunk);
+    auto new_node = details_::allocate_node<node_type>(
+        get_allocator(), std::move(chunk), std::move(node_stats));
+    if constexpr (node_type::is_contiguous) {
+      new_node->set_origin(next_origin_());
+    }
 
     if (*this == empty) {
+      stats_.chunk_transition();
       start_chunk_(new_node);
     }
 
@@ -167,6 +703,11 @@ class stream {
     tail_ = std::move(new_node);
   }
 
+  allocator_type get_allocator() const {
+    precondition(!is_moved_(), moved_err_msg);
+    return tail_->get_allocator();
+  }
+
   void finish() {
     precondition(!is_moved_(), moved_err_msg);
     precondition(!tail_->is_final());
@@ -176,12 +717,13 @@ class stream {
 
   checkpoint_type checkpoint() {
     precondition(!is_moved_(), moved_err_msg);
-    return checkpoint_type{position_, current_chunk_};
+    return checkpoint_type{position_, current_chunk_, stats_.checkpoint()};
   }
 
   void rollback(checkpoint_type cp) {
     precondition(!is_moved_(), moved_err_msg);
 
+    stats_.rollback(cp.stats_);
     position_ = std::move(cp.position_);
     current_chunk_ = std::move(cp.current_chunk_);
     chunk_end_ = current_chunk_->end();
@@ -192,29 +734,460 @@ class stream {
     }
   }
 
+  // Keeps every chunk from the current position onward alive for as long as
+  // it exists, so that scoped checkpoints don't have to.
+  //
+  // Scopes must be destroyed in the reverse order of their creation, and the
+  // stream must not be moved while one of them exists.
+  class retention_scope {
+   public:
+    explicit retention_scope(stream& owner) : owner_(&owner) {
+      owner_->begin_retention_();
+    }
+
+    retention_scope(const retention_scope&) = delete;
+    retention_scope& operator=(const retention_scope&) = delete;
+
+    ~retention_scope() {
+      owner_->end_retention_();
+    }
+
+   private:
+    stream* owner_;
+  };
+
+  // usage:
+  //   auto scope = feed.retain();
+  //   auto cp = feed.scoped_checkpoint();
+  //   if (!parse_alternative(feed)) {
+  //     feed.rollback(cp);
+  //   }
+  [[nodiscard]] retention_scope retain() {
+    precondition(!is_moved_(), moved_err_msg);
+    return retention_scope{*this};
+  }
+
+  // A checkpoint that costs no reference counting, but that is only valid
+  // until the outermost live retention_scope goes away.
+  scoped_checkpoint_type scoped_checkpoint() {
+    precondition(!is_moved_(), moved_err_msg);
+    precondition(retention_depth_ > 0,
+                 "scoped checkpoints require a retention_scope");
+
+    return scoped_checkpoint_type{position_,
+                                  current_chunk_.get(),
+                                  retention_scope_id_,
+                                  stats_.scoped_checkpoint()};
+  }
+
+  void rollback(const scoped_checkpoint_type& cp) {
+    precondition(!is_moved_(), moved_err_msg);
+    precondition(
+        retention_depth_ > 0 && cp.scope_id_ == retention_scope_id_,
+        "scoped checkpoint used outside of its retention_scope");
+
+    stats_.rollback(cp.stats_);
+    position_ = cp.position_;
+
+    // Only moving back to a different chunk costs a reference.
+    if (cp.current_chunk_ != current_chunk_.get()) {
+      current_chunk_ = details_::node_ptr<node_type>::share(cp.current_chunk_);
+      chunk_end_ = current_chunk_->end();
+    }
+
+    if (position_ == chunk_end_ && !at_last_chunk_()) {
+      start_chunk_(current_chunk_->next());
+    }
+  }
+
+  // Returns an independent reader, starting at the current position, that
+  // shares the stream's chunks.
+  // usage:
+  //   auto audit = feed.cursor();
+  //   parse(feed);
+  //   log(audit);
+  cursor_type cursor() const {
+    precondition(!is_moved_(), moved_err_msg);
+    return cursor_type{current_chunk_, position_, chunk_end_};
+  }
+
+  // Returns how many elements precede the current position, since the start
+  // of the stream. This is only computed when asked for.
+  std::size_t offset() const requires details_::contiguous_chunk<chunk_type> {
+    precondition(!is_moved_(), moved_err_msg);
+    return offset_at_(*current_chunk_, position_);
+  }
+
+  std::size_t offset_of(const checkpoint_type& cp) const
+      requires details_::contiguous_chunk<chunk_type> {
+    precondition(!is_moved_(), moved_err_msg);
+    return offset_at_(*cp.current_chunk_, cp.position_);
+  }
+
+  std::size_t offset_of(const scoped_checkpoint_type& cp) const
+      requires details_::contiguous_chunk<chunk_type> {
+    precondition(!is_moved_(), moved_err_msg);
+    return offset_at_(*cp.current_chunk_, cp.position_);
+  }
+
+  // Returns how many elements lie between two checkpoints.
+  difference_type distance(const checkpoint_type& from,
+                           const checkpoint_type& to) const
+      requires details_::contiguous_chunk<chunk_type> {
+    return static_cast<difference_type>(offset_of(to)) -
+           static_cast<difference_type>(offset_of(from));
+  }
+
+  difference_type distance(const scoped_checkpoint_type& from,
+                           const scoped_checkpoint_type& to) const
+      requires details_::contiguous_chunk<chunk_type> {
+    return static_cast<difference_type>(offset_of(to)) -
+           static_cast<difference_type>(offset_of(from));
+  }
+
+  // Returns the elements between two checkpoints, from preceding to, without
+  // copying them.
+  // usage:
+  //   auto start = feed.checkpoint();
+  //   skip_identifier(feed);
+  //   auto name = feed.slice(start, feed.checkpoint());
+  //
+  // The slice keeps the chunks holding its elements alive on its own.
+  rope_type slice(const checkpoint_type& from, const checkpoint_type& to) const
+      requires details_::contiguous_chunk<chunk_type> {
+    return slice_(
+        from.current_chunk_.get(), from.position_, distance(from, to));
+  }
+
+  rope_type slice(const scoped_checkpoint_type& from,
+                  const scoped_checkpoint_type& to) const
+      requires details_::contiguous_chunk<chunk_type> {
+    return slice_(from.current_chunk_, from.position_, distance(from, to));
+  }
+
+  // Keeps track of line boundaries, so that locations can be reported. This
+  // must be called before anything is appended to the stream.
+  //
+  // Each chunk is scanned for newlines once, when the next one is appended,
+  // and the chunk being read is only scanned as far as needed when a location
+  // is asked for. Nothing is done while reading.
+  void track_lines() requires details_::contiguous_chunk<chunk_type> &&
+      details_::line_countable<value_type> {
+    precondition(!is_moved_(), moved_err_msg);
+    precondition(!tail_->next() && tail_->begin() == tail_->end(),
+                 "lines must be tracked from the start of the stream");
+    track_lines_ = true;
+  }
+
+  // usage:
+  //   auto start = feed.checkpoint();
+  //   if (!parse_statement(feed)) {
+  //     auto where = feed.location_of(start);
+  //     report(where.line, where.column);
+  //   }
+  location location_of(const checkpoint_type& cp) const
+      requires details_::contiguous_chunk<chunk_type> &&
+      details_::line_countable<value_type> {
+    precondition(!is_moved_(), moved_err_msg);
+    precondition(track_lines_, "locations require track_lines()");
+    return location_at_(*cp.current_chunk_, cp.position_);
+  }
+
+  location location_of(const scoped_checkpoint_type& cp) const
+      requires details_::contiguous_chunk<chunk_type> &&
+      details_::line_countable<value_type> {
+    precondition(!is_moved_(), moved_err_msg);
+    precondition(track_lines_, "locations require track_lines()");
+    return location_at_(*cp.current_chunk_, cp.position_);
+  }
+
+  location current_location() const
+      requires details_::contiguous_chunk<chunk_type> &&
+      details_::line_countable<value_type> {
+    precondition(!is_moved_(), moved_err_msg);
+    precondition(track_lines_, "locations require track_lines()");
+    return location_at_(*current_chunk_, position_);
+  }
+
+  // Only available when building with ABU_FEED_COLLECT_STATS.
+  // usage:
+  //   auto stats = feed.stats();
+  //   report(stats.retained_elements, stats.oldest_checkpoint_age);
+  stream_stats stats() const requires details_::collect_stats {
+    precondition(!is_moved_(), moved_err_msg);
+    return stats_.snapshot();
+  }
+
+ protected:
+  // To be called when the data of the tail chunk grew in place, which
+  // requires its iterators to remain valid.
+  void tail_grew_() {
+    tail_->refresh();
+    if (at_last_chunk_()) {
+      chunk_end_ = tail_->end();
+    }
+  }
+
  private:
   bool is_moved_() const {
     return tail_ == nullptr;
   }
 
+  // Whether the next n elements have all been appended already.
+  bool is_available_(std::size_t n) const
+      requires details_::contiguous_chunk<chunk_type> {
+    auto here = current_span().size();
+    if (here >= n) {
+      return true;
+    }
+
+    n -= here;
+    for (auto* node = current_chunk_->next().get(); node;
+         node = node->next().get()) {
+      auto len = static_cast<std::size_t>(node->end() - node->begin());
+      if (len >= n) {
+        return true;
+      }
+      n -= len;
+    }
+    return false;
+  }
+
+  void begin_retention_() {
+    if (retention_depth_++ == 0) {
+      retained_ = current_chunk_;
+      ++retention_scope_id_;
+    }
+  }
+
+  void end_retention_() {
+    assume(retention_depth_ > 0);
+    if (--retention_depth_ == 0) {
+      retained_.reset();
+    }
+  }
+
+  rope_type slice_(node_type* node,
+                   typename node_type::iterator pos,
+                   difference_type n) const {
+    precondition(n >= 0, "slicing backwards");
+    if (n == 0) {
+      return {};
+    }
+
+    // Checkpoints can sit at the very end of their chunk.
+    while (pos == node->end()) {
+      node = node->next().get();
+      pos = node->begin();
+    }
+    return rope_type{details_::node_ptr<node_type>::share(node),
+                     pos,
+                     static_cast<std::size_t>(n)};
+  }
+
+  static std::size_t offset_at_(const node_type& node,
+                                typename node_type::iterator pos) {
+    return node.origin().offset +
+           static_cast<std::size_t>(pos - node.begin());
+  }
+
+  static location location_at_(const node_type& node,
+                               typename node_type::iterator pos) {
+    return details_::advance_location_(
+        node.origin(), std::span<const value_type>{node.begin(), pos});
+  }
+
+  // The tail is done growing once something is appended after it.
+  location next_origin_() const {
+    auto origin = tail_->origin();
+    auto data = std::span<const value_type>{tail_->begin(), tail_->end()};
+
+    if constexpr (details_::line_countable<value_type>) {
+      if (track_lines_) {
+        return details_::advance_location_(origin, data);
+      }
+    }
+    origin.offset += data.size();
+    return origin;
+  }
+
   bool at_last_chunk_() const {
     return current_chunk_ == tail_;
   }
 
-  void start_chunk_(mem::ref_count_ptr<node_type> chunk) {
+  void next_chunk_() {
+    stats_.chunk_transition();
+    start_chunk_(current_chunk_->next());
+  }
+
+  void start_chunk_(details_::node_ptr<node_type> chunk) {
     position_ = chunk->begin();
     chunk_end_ = chunk->end();
     current_chunk_ = std::move(chunk);
   }
 
-  using chunk_iterator_type = std::ranges::iterator_t<node_type>;
-  using sentinel_type = std::ranges::sentinel_t<node_type>;
+  using chunk_iterator_type = typename node_type::iterator;
+  using sentinel_type = typename node_type::sentinel;
 
-  mem::ref_count_ptr<node_type> current_chunk_;
+  details_::node_ptr<node_type> current_chunk_;
   chunk_iterator_type position_;
   sentinel_type chunk_end_;
 
-  mem::ref_count_ptr<node_type> tail_;
+  details_::node_ptr<node_type> tail_;
+
+  // Watermark set by the outermost retention_scope.
+  details_::node_ptr<node_type> retained_;
+  std::size_t retention_depth_ = 0;
+  std::size_t retention_scope_id_ = 0;
+
+  bool track_lines_ = false;
+
+  [[no_unique_address]] details_::stats_recorder stats_;
+};
+
+// A reader over the chunks of a stream, with its own position and
+// checkpoints.
+//
+// A chunk is only released once the stream, all of its cursors and all of
+// their checkpoints have moved past it. Cursors can outlive their stream, and
+// keep seeing what gets appended to it while it's alive.
+template <Chunk ChunkT, typename Alloc>
+class stream_cursor {
+  static constexpr const char* moved_err_msg =
+      "Using stream cursor that was moved";
+
+ public:
+  using chunk_type = const ChunkT;
+  using node_type = details_::stream_node<chunk_type, Alloc>;
+  using checkpoint_type = details_::stream_cursor_checkpoint<ChunkT, Alloc>;
+
+  using iterator_tag = std::input_iterator_tag;
+  using difference_type = std::ptrdiff_t;
+  using value_type = std::ranges::range_value_t<ChunkT>;
+
+  stream_cursor(stream_cursor&&) = default;
+  stream_cursor(const stream_cursor&) = delete;
+
+  stream_cursor& operator=(stream_cursor&&) = default;
+  stream_cursor& operator=(const stream_cursor&) = delete;
+
+  decltype(auto) operator*() const {
+    precondition(!is_moved_(), moved_err_msg);
+    catch_up_();
+    precondition(position_ != chunk_end_);
+
+    return *position_;
+  }
+
+  stream_cursor& operator++() {
+    precondition(!is_moved_(), moved_err_msg);
+    catch_up_();
+    precondition(position_ != chunk_end_);
+
+    // Moving on right away lets go of finished chunks sooner.
+    ++position_;
+    catch_up_();
+    return *this;
+  }
+
+  void operator++(int) {
+    ++(*this);
+  }
+
+  bool operator==(const empty_feed_t&) const {
+    precondition(!is_moved_(), moved_err_msg);
+    catch_up_();
+    return position_ == chunk_end_;
+  }
+
+  bool operator==(const end_of_feed_t&) const {
+    precondition(!is_moved_(), moved_err_msg);
+    catch_up_();
+    return position_ == chunk_end_ && current_chunk_->is_final();
+  }
+
+  // Returns the unread remainder of the current chunk.
+  std::span<const value_type> current_span() const
+      requires std::ranges::contiguous_range<chunk_type> {
+    precondition(!is_moved_(), moved_err_msg);
+    chunk_end_ = current_chunk_->end();
+    catch_up_();
+
+    auto remaining = std::ranges::distance(position_, chunk_end_);
+    return {std::to_address(position_), static_cast<std::size_t>(remaining)};
+  }
+
+  // Skips n elements, which must all be currently available.
+  void advance(difference_type n) {
+    precondition(!is_moved_(), moved_err_msg);
+    precondition(n >= 0);
+
+    chunk_end_ = current_chunk_->end();
+    n = std::ranges::advance(position_, n, chunk_end_);
+    while (n > 0) {
+      precondition(current_chunk_->next() != nullptr,
+                   "advancing past the available data");
+
+      start_chunk_(current_chunk_->next());
+      n = std::ranges::advance(position_, n, chunk_end_);
+    }
+    catch_up_();
+  }
+
+  checkpoint_type checkpoint() {
+    precondition(!is_moved_(), moved_err_msg);
+    return checkpoint_type{position_, current_chunk_};
+  }
+
+  void rollback(checkpoint_type cp) {
+    precondition(!is_moved_(), moved_err_msg);
+
+    position_ = std::move(cp.position_);
+    current_chunk_ = std::move(cp.current_chunk_);
+    chunk_end_ = current_chunk_->end();
+  }
+
+ private:
+  friend class stream<ChunkT, Alloc>;
+
+  using chunk_iterator_type = typename node_type::iterator;
+  using sentinel_type = typename node_type::sentinel;
+
+  stream_cursor(details_::node_ptr<node_type> chunk,
+                chunk_iterator_type position,
+                sentinel_type chunk_end)
+      : current_chunk_(std::move(chunk)),
+        position_(std::move(position)),
+        chunk_end_(std::move(chunk_end)) {}
+
+  bool is_moved_() const {
+    return current_chunk_ == nullptr;
+  }
+
+  // Moves into chunks that were appended since we reached the end of the
+  // current one.
+  void catch_up_() const {
+    while (position_ == chunk_end_) {
+      // The chunk might have grown in place since we started it.
+      chunk_end_ = current_chunk_->end();
+      if (position_ != chunk_end_ || !current_chunk_->next()) {
+        return;
+      }
+      start_chunk_(current_chunk_->next());
+    }
+  }
+
+  void start_chunk_(details_::node_ptr<node_type> chunk) const {
+    position_ = chunk->begin();
+    chunk_end_ = chunk->end();
+    current_chunk_ = std::move(chunk);
+  }
+
+  // The position only changes in const members when catching up with the
+  // stream, which is not observable from the feed interface.
+  mutable details_::node_ptr<node_type> current_chunk_;
+  mutable chunk_iterator_type position_;
+  mutable sentinel_type chunk_end_;
 };
 
 }  // namespace abu::feed
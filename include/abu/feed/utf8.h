@@ -0,0 +1,557 @@
+// Copyright 2021 Francois Chabot
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ABU_FEED_UTF8_H
+#define ABU_FEED_UTF8_H
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <utility>
+
+#include "abu/feed/algorithm.h"
+#include "abu/feed/concepts.h"
+#include "abu/feed/debug.h"
+#include "abu/feed/decoded_feed.h"
+#include "abu/feed/tags.h"
+
+// Reading UTF-8 text out of feeds of bytes.
+//
+// usage:
+//   auto text = abu::feed::validate_utf8(std::ref(data));
+//   auto code_points = abu::feed::decode_utf8(std::ref(data));
+//
+// Both throw utf8_error when they reach malformed data. A sequence that is
+// cut short at the end of the available data is waited for, and only
+// reported as an error once the source reaches its end_of_feed.
+
+namespace abu::feed {
+
+class utf8_error : public std::runtime_error {
+ public:
+  using std::runtime_error::runtime_error;
+};
+
+namespace details_ {
+enum class utf8_status { ok, incomplete, invalid };
+
+struct utf8_scan {
+  std::size_t valid = 0;
+  utf8_status status = utf8_status::ok;
+};
+
+// n must be a multiple of 8.
+inline bool is_ascii_(const std::uint8_t* bytes, std::size_t n) {
+  constexpr std::uint64_t high_bits = 0x8080808080808080;
+  std::uint64_t bits = 0;
+  for (std::size_t i = 0; i < n; i += 8) {
+    std::uint64_t word;
+    std::memcpy(&word, bytes + i, sizeof(word));
+    bits |= word;
+  }
+  return (bits & high_bits) == 0;
+}
+
+// Returns the length of the sequence starting with lead, or 0 when lead
+// can't start one.
+inline std::size_t utf8_sequence_length(std::uint8_t lead) {
+  if (lead < 0x80) {
+    return 1;
+  }
+  if (lead < 0xc2) {
+    return 0;
+  }
+  if (lead < 0xe0) {
+    return 2;
+  }
+  if (lead < 0xf0) {
+    return 3;
+  }
+  return lead < 0xf5 ? 4 : 0;
+}
+
+// Checks a sequence of len bytes, of which only the first available might be
+// there yet. Rejects overlong forms, surrogates and values past U+10FFFF.
+inline utf8_status check_utf8_sequence(const std::uint8_t* bytes,
+                                       std::size_t available,
+                                       std::size_t len) {
+  if (len == 0) {
+    return utf8_status::invalid;
+  }
+
+  std::uint8_t low = 0x80;
+  std::uint8_t high = 0xbf;
+  switch (bytes[0]) {
+    case 0xe0:
+      low = 0xa0;
+      break;
+    case 0xed:
+      high = 0x9f;
+      break;
+    case 0xf0:
+      low = 0x90;
+      break;
+    case 0xf4:
+      high = 0x8f;
+      break;
+    default:
+      break;
+  }
+
+  for (std::size_t i = 1; i < std::min(available, len); ++i) {
+    if (bytes[i] < low || bytes[i] > high) {
+      return utf8_status::invalid;
+    }
+    low = 0x80;
+    high = 0xbf;
+  }
+  return available < len ? utf8_status::incomplete : utf8_status::ok;
+}
+
+inline char32_t decode_utf8_sequence(const std::uint8_t* bytes,
+                                     std::size_t len) {
+  constexpr std::uint8_t lead_masks[] = {0, 0x7f, 0x1f, 0x0f, 0x07};
+
+  char32_t result = bytes[0] & lead_masks[len];
+  for (std::size_t i = 1; i < len; ++i) {
+    result = (result << 6) | (bytes[i] & 0x3fu);
+  }
+  return result;
+}
+
+template <byte_like T>
+const std::uint8_t* as_octets(std::span<const T> data) {
+  return reinterpret_cast<const std::uint8_t*>(data.data());
+}
+
+// Finds how much of data is made of complete, valid sequences, one sequence
+// at a time.
+template <byte_like T>
+utf8_scan scan_utf8_sequences(std::span<const T> data) {
+  const auto* bytes = as_octets(data);
+  const auto n = data.size();
+
+  std::size_t i = 0;
+  while (i < n) {
+    auto len = utf8_sequence_length(bytes[i]);
+    auto status = check_utf8_sequence(bytes + i, n - i, len);
+    if (status != utf8_status::ok) {
+      return {i, status};
+    }
+    i += len;
+  }
+  return {n, utf8_status::ok};
+}
+
+// Validation runs as a shift-based DFA, which needs no branches: each byte
+// maps to a row holding the next state for every current state, in 6-bit
+// fields, and states are the offset of their field.
+namespace utf8_dfa {
+inline constexpr unsigned accept = 0;
+inline constexpr unsigned reject = 6;
+inline constexpr unsigned one_left = 12;
+inline constexpr unsigned two_left = 18;
+inline constexpr unsigned two_left_e0 = 24;
+inline constexpr unsigned two_left_ed = 30;
+inline constexpr unsigned three_left = 36;
+inline constexpr unsigned three_left_f0 = 42;
+inline constexpr unsigned three_left_f4 = 48;
+inline constexpr unsigned state_count = 9;
+
+constexpr unsigned next_state(unsigned state, unsigned byte) {
+  if (state == accept) {
+    if (byte < 0x80) {
+      return accept;
+    }
+    if (byte >= 0xc2 && byte < 0xe0) {
+      return one_left;
+    }
+    if (byte == 0xe0) {
+      return two_left_e0;
+    }
+    if (byte == 0xed) {
+      return two_left_ed;
+    }
+    if (byte > 0xe0 && byte < 0xf0) {
+      return two_left;
+    }
+    if (byte == 0xf0) {
+      return three_left_f0;
+    }
+    if (byte == 0xf4) {
+      return three_left_f4;
+    }
+    if (byte > 0xf0 && byte < 0xf4) {
+      return three_left;
+    }
+    return reject;
+  }
+
+  unsigned low = 0x80;
+  unsigned high = 0xbf;
+  unsigned next = reject;
+  switch (state) {
+    case one_left:
+      next = accept;
+      break;
+    case two_left:
+      next = one_left;
+      break;
+    case two_left_e0:
+      low = 0xa0;
+      next = one_left;
+      break;
+    case two_left_ed:
+      high = 0x9f;
+      next = one_left;
+      break;
+    case three_left:
+      next = two_left;
+      break;
+    case three_left_f0:
+      low = 0x90;
+      next = two_left;
+      break;
+    case three_left_f4:
+      high = 0x8f;
+      next = two_left;
+      break;
+    default:
+      break;
+  }
+  return byte >= low && byte <= high ? next : reject;
+}
+
+constexpr std::array<std::uint64_t, 256> make_rows() {
+  std::array<std::uint64_t, 256> rows = {};
+  for (unsigned byte = 0; byte < 256; ++byte) {
+    for (unsigned i = 0; i < state_count; ++i) {
+      rows[byte] |= std::uint64_t{next_state(i * 6, byte)} << (i * 6);
+    }
+  }
+  return rows;
+}
+
+inline constexpr std::array<std::uint64_t, 256> rows = make_rows();
+}  // namespace utf8_dfa
+
+// Finds how much of data is made of complete, valid sequences.
+//
+// Stepping the DFA is one long dependency chain, so data is split in two
+// halves at the start of a sequence, which are run side by side. Blocks of
+// ASCII are skipped whole.
+template <byte_like T>
+utf8_scan scan_utf8(std::span<const T> data) {
+  constexpr std::size_t block = 64;
+  const auto* bytes = as_octets(data);
+  const auto n = data.size();
+
+  // Shifts only look at the low 6 bits, so states are left unmasked.
+  auto step = [](std::uint64_t state, std::uint8_t byte) {
+    return utf8_dfa::rows[byte] >> (state & 63);
+  };
+  auto at = [](std::uint64_t state, unsigned expected) {
+    return (state & 63) == expected;
+  };
+  auto run = [&](std::uint64_t state, std::size_t first, std::size_t last) {
+    while (first < last) {
+      if (at(state, utf8_dfa::accept) && last - first >= block &&
+          is_ascii_(bytes + first, block)) {
+        first += block;
+        continue;
+      }
+      for (auto end = std::min(last, first + block); first < end; ++first) {
+        state = step(state, bytes[first]);
+      }
+    }
+    return state;
+  };
+
+  auto mid = n / 2;
+  while (mid < n && (bytes[mid] & 0xc0) == 0x80) {
+    ++mid;
+  }
+
+  std::uint64_t low = utf8_dfa::accept;
+  std::uint64_t high = utf8_dfa::accept;
+  std::size_t i = 0;
+  std::size_t j = mid;
+  for (; mid - i >= block && n - j >= block; i += block, j += block) {
+    bool skip_low = at(low, utf8_dfa::accept) && is_ascii_(bytes + i, block);
+    bool skip_high =
+        at(high, utf8_dfa::accept) && is_ascii_(bytes + j, block);
+
+    if (!skip_low && !skip_high) {
+      for (std::size_t k = 0; k < block; ++k) {
+        low = step(low, bytes[i + k]);
+        high = step(high, bytes[j + k]);
+      }
+    } else if (!skip_low) {
+      low = run(low, i, i + block);
+    } else if (!skip_high) {
+      high = run(high, j, j + block);
+    }
+  }
+  low = run(low, i, mid);
+  high = run(high, j, n);
+
+  // The first half is followed by a lead byte, so it can't end mid-sequence.
+  if (!at(low, utf8_dfa::accept) || at(high, utf8_dfa::reject)) {
+    // Pins down the error the slow way.
+    return scan_utf8_sequences(data);
+  }
+
+  if (at(high, utf8_dfa::accept)) {
+    return {n, utf8_status::ok};
+  }
+
+  // The last sequence is cut short.
+  auto start = n - 1;
+  while ((bytes[start] & 0xc0) == 0x80) {
+    --start;
+  }
+  return {start, utf8_status::incomplete};
+}
+
+// Decodes bytes into code points, for decoded_feed.
+struct utf8_decoder {
+  template <byte_like T>
+  decode_result operator()(std::span<const T> in,
+                           std::span<char32_t> out,
+                           bool last) const {
+    const auto* bytes = as_octets(in);
+    std::size_t i = 0;
+    std::size_t o = 0;
+
+    while (i < in.size() && o < out.size()) {
+      if (in.size() - i >= 8 && out.size() - o >= 8 &&
+          is_ascii_(bytes + i, 8)) {
+        for (std::size_t k = 0; k < 8; ++k) {
+          out[o + k] = bytes[i + k];
+        }
+        i += 8;
+        o += 8;
+        continue;
+      }
+
+      auto len = utf8_sequence_length(bytes[i]);
+      auto status = check_utf8_sequence(bytes + i, in.size() - i, len);
+      if (status != utf8_status::ok) {
+        // Errors are only reported once everything before them was read.
+        if (i > 0 || (status == utf8_status::incomplete && !last)) {
+          break;
+        }
+        throw utf8_error(status == utf8_status::invalid
+                             ? "invalid UTF-8 sequence"
+                             : "truncated UTF-8 sequence");
+      }
+
+      out[o++] = decode_utf8_sequence(bytes + i, len);
+      i += len;
+    }
+    return {i, o};
+  }
+};
+}  // namespace details_
+
+// Presents the bytes of a contiguous feed once they are known to form valid
+// UTF-8, without copying them.
+//
+// Each block of the source is validated as a whole the first time it is
+// looked at. current_span() only extends up to the end of the last complete
+// sequence, and a sequence that straddles blocks is checked on its own.
+template <typename F>
+requires ContiguousFeed<details_::source_feed_t<F>> &&
+    details_::byte_like<details_::source_value_t<F>>
+class validated_utf8_feed {
+  using source_type = details_::source_feed_t<F>;
+  using source_checkpoint_type =
+      decltype(std::declval<source_type&>().checkpoint());
+
+ public:
+  using iterator_tag = std::input_iterator_tag;
+  using difference_type = std::ptrdiff_t;
+  using value_type = details_::source_value_t<F>;
+
+  class checkpoint_type {
+   private:
+    friend class validated_utf8_feed;
+
+    checkpoint_type(source_checkpoint_type source, std::size_t validated)
+        : source_(std::move(source)), validated_(validated) {}
+
+    source_checkpoint_type source_;
+    std::size_t validated_;
+  };
+
+  template <typename U>
+  requires std::constructible_from<details_::member_storage_t<F>, U>
+  explicit validated_utf8_feed(U&& source)
+      : source_(std::forward<U>(source)) {}
+
+  decltype(auto) operator*() const {
+    ensure_validated_();
+    precondition(validated_ > 0);
+    return *source_feed_();
+  }
+
+  validated_utf8_feed& operator++() {
+    ensure_validated_();
+    precondition(validated_ > 0);
+    ++source_feed_();
+    --validated_;
+    return *this;
+  }
+
+  void operator++(int) {
+    ++(*this);
+  }
+
+  bool operator==(const empty_feed_t&) const {
+    return !ensure_validated_();
+  }
+
+  bool operator==(const end_of_feed_t&) const {
+    return *this == empty && source_feed_() == end_of_feed;
+  }
+
+  // Returns the validated remainder of the current block.
+  std::span<const value_type> current_span() const {
+    if (*this == empty) {
+      return {};
+    }
+    auto block = source_feed_().current_span();
+    return block.first(std::min(validated_, block.size()));
+  }
+
+  // Skips n elements, which must all be currently available.
+  void advance(difference_type n) {
+    precondition(n >= 0);
+
+    while (n > 0) {
+      auto block = current_span();
+      precondition(!block.empty(), "advancing past the available data");
+
+      auto step = std::min(n, std::ssize(block));
+      source_feed_().advance(
+          static_cast<std::iter_difference_t<source_type>>(step));
+      validated_ -= static_cast<std::size_t>(step);
+      n -= step;
+    }
+  }
+
+  checkpoint_type checkpoint() {
+    return checkpoint_type{source_feed_().checkpoint(), validated_};
+  }
+
+  void rollback(checkpoint_type cp) {
+    source_feed_().rollback(std::move(cp.source_));
+    validated_ = cp.validated_;
+  }
+
+ private:
+  source_type& source_feed_() const {
+    return details_::unwrap_member(source_);
+  }
+
+  // Returns whether the element at the current position is validated,
+  // validating what follows it once everything validated so far was read.
+  bool ensure_validated_() const {
+    return validated_ > 0 || validate_();
+  }
+
+  // Validates what follows the current position, and returns whether any
+  // of it could be.
+  bool validate_() const {
+    auto block = source_feed_().current_span();
+    if (block.empty()) {
+      return false;
+    }
+
+    auto scan = details_::scan_utf8(block);
+    if (scan.valid > 0) {
+      validated_ = scan.valid;
+      return true;
+    }
+    if (scan.status == details_::utf8_status::invalid) {
+      throw utf8_error("invalid UTF-8 sequence");
+    }
+    return validate_straddling_();
+  }
+
+  // The sequence at the current position continues past the current block.
+  bool validate_straddling_() const {
+    auto& src = source_feed_();
+    auto cp = src.checkpoint();
+
+    std::array<std::uint8_t, 4> bytes;
+    auto lead = std::bit_cast<std::uint8_t>(*src);
+    auto len = details_::utf8_sequence_length(lead);
+    std::size_t available = 0;
+    while (available < len && src != empty) {
+      bytes[available++] = std::bit_cast<std::uint8_t>(*src);
+      ++src;
+    }
+    bool finished = src == end_of_feed;
+    src.rollback(std::move(cp));
+
+    switch (details_::check_utf8_sequence(bytes.data(), available, len)) {
+      case details_::utf8_status::ok:
+        validated_ = len;
+        return true;
+      case details_::utf8_status::incomplete:
+        if (!finished) {
+          return false;
+        }
+        throw utf8_error("truncated UTF-8 sequence");
+      case details_::utf8_status::invalid:
+        break;
+    }
+    throw utf8_error("invalid UTF-8 sequence");
+  }
+
+  // Validation happens as the feed is looked at, which is not observable
+  // from the feed interface.
+  mutable details_::member_storage_t<F> source_;
+
+  // How many elements past the current position are known to be valid.
+  mutable std::size_t validated_ = 0;
+};
+
+// usage:
+//   auto text = abu::feed::validate_utf8(std::ref(data));
+template <typename F>
+auto validate_utf8(F&& feed) {
+  using result_type = validated_utf8_feed<details_::stored_feed_t<F>>;
+  return result_type{std::forward<F>(feed)};
+}
+
+// Decodes a feed of bytes into a feed of char32_t code points.
+// usage:
+//   auto code_points = abu::feed::decode_utf8(std::ref(data));
+template <typename F>
+auto decode_utf8(F&& feed) {
+  return decode<char32_t>(std::forward<F>(feed), details_::utf8_decoder{});
+}
+
+}  // namespace abu::feed
+
+#endif
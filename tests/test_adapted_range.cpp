@@ -12,12 +12,27 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <array>
+#include <list>
+#include <type_traits>
 #include <vector>
 
 #include "abu/feed.h"
 #include "gtest/gtest.h"
 
+// Contiguous ranges are walked with raw pointers.
+static_assert(std::is_same_v<
+              decltype(abu::feed::adapt_range(std::vector<int>{}))::
+                  checkpoint_type,
+              const int*>);
+
+// Without losing the constness of the range.
+static_assert(std::is_same_v<decltype(*abu::feed::adapt_range(
+                                 std::declval<std::vector<int>&>().begin(),
+                                 std::declval<std::vector<int>&>().end())),
+                             int&>);
+
 TEST(adapted_range, basic_api_test) {
   std::vector<int> raw_data = {1, 2, 3, 4};
 
@@ -60,6 +75,23 @@ TEST(adapted_range, rollback) {
   EXPECT_EQ(sut, abu::feed::end_of_feed);
 }
 
+TEST(adapted_range, bulk_access) {
+  std::vector<int> raw_data = {1, 2, 3, 4};
+
+  auto sut = abu::feed::adapt_range(raw_data);
+
+  EXPECT_EQ(sut.current_span().size(), 4);
+  sut.advance(3);
+  ASSERT_EQ(sut.current_span().size(), 1);
+  EXPECT_EQ(sut.current_span()[0], 4);
+
+  sut.advance(1);
+  EXPECT_TRUE(sut.current_span().empty());
+  EXPECT_EQ(sut, abu::feed::end_of_feed);
+
+  EXPECT_DEATH(sut.advance(1), "past the available data");
+}
+
 constexpr int cste_feed_test(abu::FeedOf<int> auto f) {
   int accum = 0;
   while (f != abu::feed::empty) {
@@ -90,4 +122,30 @@ constexpr int cste_feed_rollback_test(abu::FeedOf<int> auto f) {
 
 static_assert(20 ==
               cste_feed_rollback_test(abu::feed::adapt_range(std::array<int, 4>{
-                  1, 2, 3, 4})));
\ No newline at end of file
+                  1, 2, 3, 4})));
+
+TEST(adapted_range, slices) {
+  std::vector<int> raw_data = {1, 2, 3, 4};
+  auto sut = abu::feed::adapt_range(raw_data);
+
+  ++sut;
+  auto start = sut.checkpoint();
+  sut.advance(2);
+  auto token = sut.slice(start, sut.checkpoint());
+
+  EXPECT_EQ(sut.distance(start, sut.checkpoint()), 2);
+  EXPECT_EQ(token.data(), raw_data.data() + 1);
+  EXPECT_EQ(token.size(), 2);
+}
+
+TEST(adapted_range, non_contiguous_slices) {
+  std::list<int> raw_data = {1, 2, 3, 4};
+  auto sut = abu::feed::adapt_range(raw_data);
+
+  auto start = sut.checkpoint();
+  sut.advance(3);
+  auto token = sut.slice(start, sut.checkpoint());
+
+  EXPECT_EQ(sut.distance(start, sut.checkpoint()), 3);
+  EXPECT_TRUE(std::ranges::equal(token, std::vector<int>{1, 2, 3}));
+}
@@ -0,0 +1,107 @@
+// Copyright 2021 Francois Chabot
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "abu/feed.h"
+#include "gtest/gtest.h"
+
+using namespace std::literals;
+
+static_assert(abu::ContiguousFeed<abu::feed::stream<std::string>>);
+static_assert(
+    abu::ContiguousFeed<decltype(abu::feed::adapt_range(std::string{}))>);
+static_assert(!abu::ContiguousFeed<abu::feed::stream<std::vector<bool>>>);
+
+TEST(algorithm, skip_until_value) {
+  abu::feed::stream<std::string> sut;
+  sut.append("abc");
+  sut.append("de\nfg");
+
+  EXPECT_TRUE(abu::feed::skip_until(sut, '\n'));
+  EXPECT_EQ(*sut, '\n');
+  ++sut;
+
+  EXPECT_FALSE(abu::feed::skip_until(sut, '\n'));
+  EXPECT_EQ(sut, abu::feed::empty);
+
+  sut.append("h\n");
+  EXPECT_TRUE(abu::feed::skip_until(sut, '\n'));
+  EXPECT_EQ(*sut, '\n');
+}
+
+TEST(algorithm, skip_until_delimiter_straddling_chunks) {
+  abu::feed::stream<std::string> sut;
+  sut.append("ab\r");
+  sut.append("c\r");
+
+  EXPECT_FALSE(abu::feed::skip_until(sut, "\r\n"sv));
+
+  // Left at the partial match, so that the search can resume.
+  EXPECT_NE(sut, abu::feed::empty);
+  EXPECT_EQ(*sut, '\r');
+
+  sut.append("\nd");
+  EXPECT_TRUE(abu::feed::skip_until(sut, "\r\n"sv));
+  EXPECT_EQ(*sut, '\r');
+  ++sut;
+  EXPECT_EQ(*sut, '\n');
+  ++sut;
+  EXPECT_EQ(*sut, 'd');
+}
+
+TEST(algorithm, find) {
+  abu::feed::stream<std::string> sut;
+  sut.append("a,b");
+  sut.append("c,,d");
+  sut.append("e,");
+  sut.append(",f");
+
+  EXPECT_EQ(abu::feed::find(sut, ','), 1);
+  EXPECT_EQ(abu::feed::find(sut, ",,"sv), 4);
+  EXPECT_EQ(abu::feed::find(sut, "e,,"sv), 7);
+  EXPECT_EQ(abu::feed::find(sut, 'x'), std::nullopt);
+  EXPECT_EQ(abu::feed::find(sut, "f,"sv), std::nullopt);
+
+  // find() does not move the feed.
+  EXPECT_EQ(*sut, 'a');
+}
+
+TEST(algorithm, count) {
+  abu::feed::stream<std::string> sut;
+  sut.append("a\nb\r");
+  sut.append("\nc\r\n\r");
+  sut.append("\n");
+
+  EXPECT_EQ(abu::feed::count(sut, '\n'), 4);
+  EXPECT_EQ(abu::feed::count(sut, "\r\n"sv), 3);
+  EXPECT_EQ(abu::feed::count(sut, "aa"sv), 0);
+  EXPECT_EQ(*sut, 'a');
+}
+
+TEST(algorithm, adapted_range) {
+  std::vector<int> data = {1, 2, 3, 1, 2, 4};
+  std::vector<int> delim = {2, 4};
+
+  auto sut = abu::feed::adapt_range(data);
+  EXPECT_EQ(abu::feed::count(sut, 2), 2);
+  EXPECT_EQ(abu::feed::find(sut, std::span<const int>{delim}), 4);
+
+  EXPECT_TRUE(abu::feed::skip_until(sut, std::span<const int>{delim}));
+  EXPECT_EQ(*sut, 2);
+  sut.advance(2);
+  EXPECT_EQ(sut, abu::feed::end_of_feed);
+}
@@ -0,0 +1,183 @@
+// Copyright 2021 Francois Chabot
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <array>
+#include <functional>
+#include <list>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "abu/feed.h"
+#include "gtest/gtest.h"
+
+namespace {
+auto feed_read(abu::Feed auto& f) {
+  auto result = *f;
+  ++f;
+  return result;
+}
+
+std::string drain(abu::feed::any_feed<char>& data) {
+  std::string result;
+  while (data != abu::feed::empty) {
+    result.push_back(feed_read(data));
+  }
+  return result;
+}
+
+// Has a checkpoint that is too large to be stored in any_checkpoint itself.
+template <typename F>
+struct bulky_checkpoint_feed : F {
+  struct checkpoint_type {
+    typename F::checkpoint_type cp;
+    std::array<char, 64> padding;
+  };
+
+  explicit bulky_checkpoint_feed(F feed) : F(std::move(feed)) {}
+
+  bulky_checkpoint_feed& operator++() {
+    F::operator++();
+    return *this;
+  }
+
+  void operator++(int) {
+    ++(*this);
+  }
+
+  checkpoint_type checkpoint() {
+    return {F::checkpoint(), {}};
+  }
+
+  void rollback(checkpoint_type cp) {
+    F::rollback(std::move(cp.cp));
+  }
+};
+}  // namespace
+
+static_assert(abu::ContiguousFeed<abu::feed::any_feed<int>>);
+
+TEST(any_feed, adapted_range) {
+  std::vector<int> raw_data = {1, 2, 3, 4};
+  abu::feed::any_feed<int> sut{abu::feed::adapt_range(raw_data)};
+
+  EXPECT_EQ(feed_read(sut), 1);
+  auto cp = sut.checkpoint();
+  EXPECT_EQ(feed_read(sut), 2);
+  EXPECT_EQ(feed_read(sut), 3);
+
+  sut.rollback(cp);
+  EXPECT_EQ(feed_read(sut), 2);
+  sut.rollback(cp);
+  EXPECT_EQ(sut.current_span().size(), 3);
+  sut.advance(3);
+
+  EXPECT_EQ(sut, abu::feed::empty);
+  EXPECT_EQ(sut, abu::feed::end_of_feed);
+}
+
+TEST(any_feed, referenced_stream) {
+  abu::feed::stream<std::string> data;
+  abu::feed::any_feed<char> sut{std::ref(data)};
+
+  EXPECT_EQ(sut, abu::feed::empty);
+  EXPECT_NE(sut, abu::feed::end_of_feed);
+
+  data.append("ab");
+  data.append("cd");
+  EXPECT_EQ(feed_read(sut), 'a');
+
+  auto cp = sut.checkpoint();
+  EXPECT_EQ(drain(sut), "bcd");
+
+  // The reads went through to the stream.
+  EXPECT_EQ(data, abu::feed::empty);
+
+  data.append("ef");
+  data.finish();
+  sut.advance(1);
+  sut.rollback(std::move(cp));
+  EXPECT_EQ(drain(sut), "bcdef");
+  EXPECT_EQ(sut, abu::feed::end_of_feed);
+}
+
+TEST(any_feed, non_contiguous_feed) {
+  abu::feed::stream<std::list<int>> data;
+  data.append({1, 2, 3});
+  data.append({4, 5});
+
+  abu::feed::any_feed<int> sut{std::move(data), 2};
+
+  EXPECT_EQ(feed_read(sut), 1);
+  auto cp = sut.checkpoint();
+  sut.advance(3);
+  EXPECT_EQ(feed_read(sut), 5);
+  EXPECT_EQ(sut, abu::feed::empty);
+
+  sut.rollback(cp);
+  EXPECT_EQ(feed_read(sut), 2);
+  EXPECT_EQ(feed_read(sut), 3);
+  sut.rollback(std::move(cp));
+  EXPECT_EQ(feed_read(sut), 2);
+  EXPECT_NE(sut, abu::feed::end_of_feed);
+}
+
+TEST(any_feed, input_range) {
+  std::istringstream input{"abcdef"};
+  abu::feed::any_feed<char> sut{
+      abu::feed::adapt_range(std::istreambuf_iterator<char>{input},
+                             std::istreambuf_iterator<char>{}),
+      4};
+
+  EXPECT_EQ(feed_read(sut), 'a');
+  auto cp = sut.checkpoint();
+  EXPECT_EQ(drain(sut), "bcdef");
+  EXPECT_EQ(sut, abu::feed::end_of_feed);
+
+  sut.rollback(std::move(cp));
+  EXPECT_EQ(drain(sut), "bcdef");
+}
+
+TEST(any_feed, checkpoint_copies) {
+  std::vector<int> raw_data = {1, 2, 3, 4};
+
+  auto check = [](abu::feed::any_feed<int>& sut) {
+    EXPECT_EQ(feed_read(sut), 1);
+    auto cp = sut.checkpoint();
+    auto copied = cp;
+    EXPECT_EQ(feed_read(sut), 2);
+
+    auto moved = std::move(cp);
+    cp = sut.checkpoint();
+    EXPECT_EQ(feed_read(sut), 3);
+
+    sut.rollback(moved);
+    EXPECT_EQ(feed_read(sut), 2);
+    sut.rollback(cp);
+    EXPECT_EQ(feed_read(sut), 3);
+
+    cp = copied;
+    sut.rollback(std::move(copied));
+    EXPECT_EQ(feed_read(sut), 2);
+    sut.rollback(std::move(cp));
+    EXPECT_EQ(feed_read(sut), 2);
+  };
+
+  abu::feed::any_feed<int> small{abu::feed::adapt_range(raw_data)};
+  check(small);
+
+  abu::feed::any_feed<int> bulky{
+      bulky_checkpoint_feed{abu::feed::adapt_range(raw_data)}};
+  check(bulky);
+}
@@ -0,0 +1,155 @@
+// Copyright 2021 Francois Chabot
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <coroutine>
+#include <exception>
+#include <queue>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "abu/feed.h"
+#include "abu/feed/awaitable_stream.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+// Minimal fire-and-forget coroutine.
+struct detached {
+  struct promise_type {
+    detached get_return_object() {
+      return {};
+    }
+    std::suspend_never initial_suspend() {
+      return {};
+    }
+    std::suspend_never final_suspend() noexcept {
+      return {};
+    }
+    void return_void() {}
+    void unhandled_exception() {
+      std::terminate();
+    }
+  };
+};
+
+template <typename StreamT>
+detached sum_all(StreamT& data, std::vector<int>& seen, bool& done) {
+  while (true) {
+    co_await data;
+    if (data == abu::feed::end_of_feed) {
+      done = true;
+      co_return;
+    }
+
+    while (data != abu::feed::empty) {
+      seen.push_back(*data);
+      ++data;
+    }
+  }
+}
+
+struct queued_executor {
+  std::queue<std::coroutine_handle<>>* pending;
+
+  void execute(std::coroutine_handle<> handle) const {
+    pending->push(handle);
+  }
+};
+}  // namespace
+
+static_assert(abu::FeedOf<abu::feed::awaitable_stream<std::vector<int>>, int>);
+
+// Appending through the base would not wake the consumer.
+static_assert(
+    !std::is_convertible_v<abu::feed::awaitable_stream<std::vector<int>>&,
+                           abu::feed::stream<std::vector<int>>&>);
+
+TEST(awaitable_stream, inline_resume) {
+  abu::feed::awaitable_stream<std::vector<int>> sut;
+  std::vector<int> seen;
+  bool done = false;
+
+  sum_all(sut, seen, done);
+  EXPECT_TRUE(seen.empty());
+
+  sut.append({1, 2});
+  EXPECT_EQ(seen, (std::vector<int>{1, 2}));
+
+  sut.append({});
+  sut.append({3});
+  EXPECT_EQ(seen, (std::vector<int>{1, 2, 3}));
+  EXPECT_FALSE(done);
+
+  sut.finish();
+  EXPECT_TRUE(done);
+}
+
+TEST(awaitable_stream, ready_data_does_not_suspend) {
+  abu::feed::awaitable_stream<std::vector<int>> sut;
+  std::vector<int> seen;
+  bool done = false;
+
+  sut.append({1, 2});
+  sut.finish();
+
+  sum_all(sut, seen, done);
+  EXPECT_EQ(seen, (std::vector<int>{1, 2}));
+  EXPECT_TRUE(done);
+}
+
+TEST(awaitable_stream, custom_executor) {
+  std::queue<std::coroutine_handle<>> pending;
+  abu::feed::awaitable_stream<std::vector<int>, queued_executor> sut{
+      queued_executor{&pending}};
+  std::vector<int> seen;
+  bool done = false;
+
+  sum_all(sut, seen, done);
+
+  sut.append({1, 2});
+  EXPECT_TRUE(seen.empty());
+  ASSERT_EQ(pending.size(), 1);
+
+  // The consumer was already handed over, so this must not resume it twice.
+  sut.append({3});
+  ASSERT_EQ(pending.size(), 1);
+
+  pending.front().resume();
+  pending.pop();
+  EXPECT_EQ(seen, (std::vector<int>{1, 2, 3}));
+
+  sut.finish();
+  ASSERT_EQ(pending.size(), 1);
+  pending.front().resume();
+  pending.pop();
+  EXPECT_TRUE(done);
+}
+
+TEST(awaitable_stream, moves_take_the_waiter) {
+  std::queue<std::coroutine_handle<>> pending;
+  abu::feed::awaitable_stream<std::vector<int>, queued_executor> original{
+      queued_executor{&pending}};
+  std::vector<int> seen;
+  bool done = false;
+
+  sum_all(original, seen, done);
+
+  auto sut = std::move(original);
+  sut.append({1});
+  ASSERT_EQ(pending.size(), 1);
+
+  // The consumer still refers to the moved-from stream.
+  pending.front().destroy();
+}
@@ -0,0 +1,90 @@
+// Copyright 2021 Francois Chabot
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "abu/feed.h"
+#include "gtest/gtest.h"
+
+namespace {
+auto feed_read(abu::Feed auto& f) {
+  auto result = *f;
+  ++f;
+  return result;
+}
+}  // namespace
+
+static_assert(abu::ContiguousFeed<abu::feed::bounded_stream<std::string>>);
+
+TEST(bounded_stream, reports_exceeded_budget) {
+  abu::feed::bounded_stream<std::vector<int>> sut{4};
+  EXPECT_EQ(sut.headroom(), 4);
+
+  EXPECT_EQ(sut.append({1, 2, 3}), abu::feed::budget_status::within);
+  EXPECT_EQ(sut.retained(), 3);
+  EXPECT_EQ(sut.headroom(), 1);
+
+  EXPECT_EQ(sut.append({4, 5}), abu::feed::budget_status::exceeded);
+  EXPECT_EQ(sut.retained(), 5);
+  EXPECT_EQ(sut.headroom(), 0);
+
+  // The data was still appended.
+  sut.advance(4);
+  EXPECT_EQ(feed_read(sut), 5);
+}
+
+TEST(bounded_stream, consuming_frees_headroom) {
+  abu::feed::bounded_stream<std::vector<int>> sut{4};
+  sut.append({1, 2});
+  sut.append({3, 4});
+  EXPECT_EQ(sut.headroom(), 0);
+
+  EXPECT_EQ(feed_read(sut), 1);
+  EXPECT_EQ(sut.headroom(), 0);
+  EXPECT_EQ(feed_read(sut), 2);
+  EXPECT_EQ(sut.headroom(), 2);
+}
+
+TEST(bounded_stream, checkpoints_count_against_budget) {
+  abu::feed::bounded_stream<std::string> sut{8};
+  sut.append("abcd");
+
+  std::optional cp = sut.checkpoint();
+  sut.append("efgh");
+  sut.advance(6);
+  EXPECT_EQ(sut.retained(), 8);
+  EXPECT_EQ(sut.append("ij"), abu::feed::budget_status::exceeded);
+
+  cp.reset();
+  EXPECT_EQ(sut.retained(), 6);
+  EXPECT_EQ(sut.headroom(), 2);
+}
+
+TEST(bounded_stream, rollback) {
+  abu::feed::bounded_stream<std::string> sut{16};
+  sut.append("ab");
+  sut.append("cd");
+  sut.finish();
+
+  auto cp = sut.checkpoint();
+  sut.advance(3);
+  sut.rollback(std::move(cp));
+  EXPECT_EQ(feed_read(sut), 'a');
+
+  sut.advance(3);
+  EXPECT_EQ(sut, abu::feed::end_of_feed);
+  EXPECT_EQ(sut.retained(), 2);
+}
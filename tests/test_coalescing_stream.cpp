@@ -0,0 +1,168 @@
+// Copyright 2021 Francois Chabot
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "abu/feed.h"
+#include "gtest/gtest.h"
+
+using namespace std::literals;
+
+namespace {
+template <typename StreamT>
+std::string drain(StreamT& data) {
+  std::string result;
+  while (data != abu::feed::empty) {
+    result.push_back(*data);
+    ++data;
+  }
+  return result;
+}
+}  // namespace
+
+static_assert(abu::ContiguousFeed<abu::feed::coalescing_stream<std::string>>);
+
+// Appending through the base would bypass the open block.
+static_assert(!std::is_convertible_v<
+              abu::feed::coalescing_stream<std::string>&,
+              abu::feed::stream<abu::feed::details_::coalesced_chunk<
+                  std::string>>&>);
+
+TEST(coalescing_stream, small_chunks_share_blocks) {
+  abu::feed::coalescing_stream<std::string> sut{4, 8};
+
+  sut.append("ab");
+  sut.append("cd");
+  sut.append("e");
+
+  // All of them went in the same block.
+  EXPECT_EQ(sut.current_span().size(), 5);
+  EXPECT_EQ(drain(sut), "abcde");
+
+  sut.append("fgh");
+  EXPECT_EQ(sut.current_span().size(), 3);
+
+  // Does not fit anymore
+  sut.append("ij");
+  EXPECT_EQ(drain(sut), "fghij");
+
+  sut.finish();
+  EXPECT_EQ(sut, abu::feed::end_of_feed);
+}
+
+TEST(coalescing_stream, large_chunks_are_kept) {
+  abu::feed::coalescing_stream<std::string> sut{4, 8};
+
+  sut.append("ab");
+  sut.append("cdefghijkl");
+  sut.append("mn");
+  sut.finish();
+
+  EXPECT_EQ(sut.current_span().size(), 2);
+  sut.advance(2);
+  EXPECT_EQ(sut.current_span().size(), 10);
+  sut.advance(10);
+  EXPECT_EQ(drain(sut), "mn");
+  EXPECT_EQ(sut, abu::feed::end_of_feed);
+}
+
+TEST(coalescing_stream, checkpoints_survive_growth) {
+  abu::feed::coalescing_stream<std::string> sut{4, 8};
+
+  sut.append("ab");
+  EXPECT_EQ(*sut, 'a');
+  ++sut;
+
+  auto cp = sut.checkpoint();
+  EXPECT_EQ(drain(sut), "b");
+
+  sut.append("cd");
+  EXPECT_EQ(drain(sut), "cd");
+
+  sut.append("efg");
+  sut.append("hij");
+  sut.rollback(cp);
+  EXPECT_EQ(drain(sut), "bcdefghij");
+}
+
+TEST(coalescing_stream, append_copy) {
+  abu::feed::coalescing_stream<std::span<const char>> sut;
+
+  {
+    std::string transient = "hello";
+    sut.append_copy(transient);
+  }
+
+  std::string big(10000, 'x');
+  sut.append_copy(big);
+  sut.finish();
+
+  EXPECT_EQ(drain(sut), "hello" + big);
+}
+
+TEST(coalescing_stream, prepare_commit) {
+  abu::feed::coalescing_stream<std::string> sut{4, 8};
+
+  auto buffer = sut.prepare(3);
+  EXPECT_EQ(buffer.size(), 8);
+  std::ranges::copy("abc"sv, buffer.begin());
+
+  // Nothing is readable until it's committed.
+  EXPECT_EQ(sut, abu::feed::empty);
+  sut.commit(2);
+  EXPECT_EQ(drain(sut), "ab");
+
+  // Commits land in the same block, right after the previous ones.
+  buffer = sut.prepare(4);
+  EXPECT_EQ(buffer.size(), 6);
+  std::ranges::copy("cdef"sv, buffer.begin());
+  sut.commit(4);
+  EXPECT_EQ(sut.current_span().size(), 4);
+  EXPECT_EQ(drain(sut), "cdef");
+
+  // Past the end of the block, a new one is started.
+  buffer = sut.prepare(10);
+  EXPECT_EQ(buffer.size(), 10);
+  std::ranges::copy("ghijklmnop"sv, buffer.begin());
+  sut.commit(10);
+  EXPECT_EQ(drain(sut), "ghijklmnop");
+
+  sut.finish();
+  EXPECT_EQ(sut, abu::feed::end_of_feed);
+}
+
+TEST(coalescing_stream, prepare_commit_with_checkpoints) {
+  abu::feed::coalescing_stream<std::string> sut{4, 8};
+
+  auto cp = sut.checkpoint();
+  std::ranges::copy("ab"sv, sut.prepare(2).begin());
+  sut.commit(2);
+  EXPECT_EQ(drain(sut), "ab");
+
+  // Committing nothing doesn't start a new block.
+  (void)sut.prepare(16);
+  sut.commit(0);
+  EXPECT_EQ(sut, abu::feed::empty);
+
+  sut.append("cd");
+  std::ranges::copy("efghij"sv, sut.prepare(6).begin());
+  sut.commit(6);
+
+  sut.rollback(cp);
+  EXPECT_EQ(drain(sut), "abcdefghij");
+}
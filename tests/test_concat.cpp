@@ -0,0 +1,111 @@
+// Copyright 2021 Francois Chabot
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <functional>
+#include <list>
+#include <string>
+#include <string_view>
+
+#include "abu/feed.h"
+#include "gtest/gtest.h"
+
+using namespace std::literals;
+
+namespace {
+std::string drain(abu::Feed auto& data) {
+  std::string result;
+  while (data != abu::feed::empty) {
+    result.push_back(*data);
+    ++data;
+  }
+  return result;
+}
+}  // namespace
+
+TEST(concat, reads_members_in_order) {
+  auto header = "ab"sv;
+  auto body = "cd"sv;
+  auto sut =
+      abu::feed::concat(abu::feed::adapt_range(header),
+                        abu::feed::adapt_range(""sv),
+                        abu::feed::adapt_range(body));
+
+  static_assert(abu::ContiguousFeed<decltype(sut)>);
+  EXPECT_EQ(drain(sut), "abcd");
+  EXPECT_TRUE(sut == abu::feed::end_of_feed);
+}
+
+TEST(concat, preamble_then_stream) {
+  auto preamble = "GET "sv;
+  abu::feed::stream<std::string> body;
+  auto sut = abu::feed::concat(abu::feed::adapt_range(preamble),
+                               std::ref(body));
+
+  EXPECT_EQ(drain(sut), "GET ");
+
+  // Empty from the live stream, but not done.
+  EXPECT_TRUE(sut == abu::feed::empty);
+  EXPECT_FALSE(sut == abu::feed::end_of_feed);
+
+  body.append("/ HTTP");
+  EXPECT_EQ(drain(sut), "/ HTTP");
+
+  body.finish();
+  EXPECT_TRUE(sut == abu::feed::end_of_feed);
+}
+
+TEST(concat, waits_for_unfinished_members) {
+  abu::feed::stream<std::string> first;
+  abu::feed::stream<std::string> second;
+  second.append("cd");
+
+  auto sut = abu::feed::concat(std::ref(first), std::ref(second));
+  first.append("ab");
+  EXPECT_EQ(drain(sut), "ab");
+
+  // second has data, but first might still get more.
+  EXPECT_TRUE(sut == abu::feed::empty);
+
+  first.finish();
+  EXPECT_EQ(drain(sut), "cd");
+}
+
+TEST(concat, checkpoints_span_members) {
+  auto header = "ab"sv;
+  abu::feed::stream<std::string> body;
+  body.append("cd");
+  body.append("ef");
+  auto sut =
+      abu::feed::concat(abu::feed::adapt_range(header), std::ref(body));
+
+  ++sut;
+  auto cp = sut.checkpoint();
+  sut.advance(4);
+  EXPECT_EQ(*sut, 'f');
+
+  sut.rollback(cp);
+  EXPECT_EQ(drain(sut), "bcdef");
+}
+
+TEST(concat, non_contiguous_members) {
+  std::list<char> header = {'a', 'b'};
+  auto sut = abu::feed::concat(abu::feed::adapt_range(header),
+                               abu::feed::adapt_range("cd"sv));
+
+  static_assert(!abu::ContiguousFeed<decltype(sut)>);
+  auto cp = sut.checkpoint();
+  EXPECT_EQ(drain(sut), "abcd");
+  sut.rollback(cp);
+  EXPECT_EQ(drain(sut), "abcd");
+}
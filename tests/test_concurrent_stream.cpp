@@ -0,0 +1,109 @@
+// Copyright 2021 Francois Chabot
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "abu/feed.h"
+#include "gtest/gtest.h"
+
+namespace {
+auto feed_read(abu::Feed auto& f) {
+  auto result = *f;
+  ++f;
+  return result;
+}
+}  // namespace
+
+static_assert(abu::FeedOf<abu::feed::concurrent_stream<std::vector<int>>, int>);
+
+TEST(concurrent_stream, basic_api_test) {
+  abu::feed::concurrent_stream<std::vector<int>> sut;
+  EXPECT_EQ(sut, abu::feed::empty);
+  EXPECT_NE(sut, abu::feed::end_of_feed);
+
+  sut.append({1, 2});
+  sut.append({});
+  sut.append({3, 4});
+  sut.finish();
+
+  EXPECT_EQ(feed_read(sut), 1);
+  EXPECT_EQ(feed_read(sut), 2);
+  EXPECT_EQ(feed_read(sut), 3);
+  EXPECT_EQ(feed_read(sut), 4);
+
+  EXPECT_EQ(sut, abu::feed::empty);
+  EXPECT_EQ(sut, abu::feed::end_of_feed);
+}
+
+TEST(concurrent_stream, resume_and_rollback) {
+  abu::feed::concurrent_stream<std::vector<int>> sut;
+  sut.append({1, 2});
+
+  auto cp = sut.checkpoint();
+  EXPECT_EQ(feed_read(sut), 1);
+  EXPECT_EQ(feed_read(sut), 2);
+  EXPECT_EQ(sut, abu::feed::empty);
+
+  auto cp2 = sut.checkpoint();
+  sut.append({3, 4});
+  EXPECT_NE(sut, abu::feed::empty);
+  EXPECT_EQ(feed_read(sut), 3);
+
+  sut.rollback(cp2);
+  EXPECT_EQ(feed_read(sut), 3);
+
+  sut.rollback(cp);
+  sut.advance(3);
+  EXPECT_EQ(feed_read(sut), 4);
+  EXPECT_EQ(sut, abu::feed::empty);
+  EXPECT_NE(sut, abu::feed::end_of_feed);
+
+  sut.finish();
+  EXPECT_EQ(sut, abu::feed::end_of_feed);
+}
+
+TEST(concurrent_stream, producer_consumer) {
+  constexpr int chunk_count = 20000;
+  abu::feed::concurrent_stream<std::vector<int>> sut;
+
+  std::thread producer([&] {
+    for (int i = 0; i < chunk_count; ++i) {
+      sut.append({i, i});
+    }
+    sut.finish();
+  });
+
+  std::int64_t accum = 0;
+  int rollbacks = 0;
+  while (sut != abu::feed::end_of_feed) {
+    if (sut == abu::feed::empty) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    auto cp = sut.checkpoint();
+    auto v = feed_read(sut);
+    if (v % 100 == 0 && rollbacks < chunk_count / 50) {
+      ++rollbacks;
+      sut.rollback(cp);
+      continue;
+    }
+    accum += v;
+  }
+  producer.join();
+
+  EXPECT_EQ(accum, std::int64_t{chunk_count - 1} * chunk_count);
+}
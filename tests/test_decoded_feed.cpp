@@ -0,0 +1,183 @@
+// Copyright 2021 Francois Chabot
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cctype>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "abu/feed.h"
+#include "gtest/gtest.h"
+
+using namespace std::literals;
+
+namespace {
+template <typename F>
+std::string drain(F& data) {
+  std::string result;
+  while (data != abu::feed::empty) {
+    result.push_back(static_cast<char>(*data));
+    ++data;
+  }
+  return result;
+}
+
+char to_upper(char c) {
+  return static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+}
+
+// Turns "\n" into a newline, and "\x" into x.
+abu::feed::decode_result unescape(std::span<const char> in,
+                                  std::span<char> out,
+                                  bool last) {
+  std::size_t consumed = 0;
+  std::size_t produced = 0;
+  while (consumed < in.size() && produced < out.size()) {
+    char c = in[consumed];
+    if (c == '\\') {
+      if (consumed + 1 == in.size()) {
+        if (!last) {
+          break;
+        }
+      } else {
+        c = in[++consumed] == 'n' ? '\n' : in[consumed];
+      }
+    }
+    out[produced++] = c;
+    ++consumed;
+  }
+  return {consumed, produced};
+}
+}  // namespace
+
+static_assert(abu::ContiguousFeed<decltype(abu::feed::transform(
+                  abu::feed::adapt_range(""sv), to_upper))>);
+
+TEST(decoded_feed, transform_stream) {
+  abu::feed::stream<std::string> data;
+  auto sut = abu::feed::transform(std::ref(data), to_upper);
+
+  data.append("ab");
+  data.append("cd");
+  EXPECT_EQ(sut.current_span().size(), 2);
+  EXPECT_EQ(drain(sut), "ABCD");
+  EXPECT_EQ(sut, abu::feed::empty);
+  EXPECT_NE(sut, abu::feed::end_of_feed);
+
+  data.append("ef");
+  data.finish();
+  EXPECT_EQ(drain(sut), "EF");
+  EXPECT_EQ(sut, abu::feed::end_of_feed);
+}
+
+TEST(decoded_feed, transform_changes_type) {
+  std::vector<std::uint16_t> raw = {0x0102, 0x0304};
+  auto swap_bytes = [](std::uint16_t v) {
+    return static_cast<std::uint16_t>(v >> 8 | v << 8);
+  };
+  auto sut = abu::feed::transform(abu::feed::adapt_range(raw), swap_bytes);
+
+  static_assert(abu::FeedOf<decltype(sut), std::uint16_t>);
+  EXPECT_EQ(*sut, 0x0201);
+  ++sut;
+  EXPECT_EQ(*sut, 0x0403);
+}
+
+TEST(decoded_feed, filter) {
+  abu::feed::stream<std::string> data;
+  auto sut = abu::feed::filter(std::ref(data), [](char c) { return c != ' '; });
+
+  data.append("a b");
+  data.append("   ");
+  EXPECT_EQ(drain(sut), "ab");
+
+  // Blocks that are entirely filtered out are skipped.
+  data.append("  c");
+  data.finish();
+  EXPECT_EQ(drain(sut), "c");
+  EXPECT_EQ(sut, abu::feed::end_of_feed);
+}
+
+TEST(decoded_feed, decode_across_chunks) {
+  abu::feed::stream<std::string> data;
+  auto sut = abu::feed::decode(std::ref(data), unescape);
+
+  data.append("a\\nb\\");
+  EXPECT_EQ(drain(sut), "a\nb");
+
+  // The escape sequence waits for the rest of it.
+  EXPECT_EQ(sut, abu::feed::empty);
+  data.append("\\c\\");
+  EXPECT_EQ(drain(sut), "\\c");
+
+  data.finish();
+  EXPECT_EQ(drain(sut), "\\");
+  EXPECT_EQ(sut, abu::feed::end_of_feed);
+}
+
+TEST(decoded_feed, rollback) {
+  abu::feed::stream<std::string> data;
+  auto sut = abu::feed::decode(std::ref(data), unescape);
+
+  data.append("ab\\");
+  data.append("ncd");
+  data.finish();
+
+  ++sut;
+  auto cp = sut.checkpoint();
+  EXPECT_EQ(drain(sut), "b\ncd");
+
+  sut.rollback(cp);
+  EXPECT_EQ(*sut, 'b');
+  ++sut;
+  ++sut;
+
+  auto cp2 = sut.checkpoint();
+  EXPECT_EQ(drain(sut), "cd");
+  sut.rollback(cp2);
+  EXPECT_EQ(drain(sut), "cd");
+
+  sut.rollback(cp);
+  EXPECT_EQ(drain(sut), "b\ncd");
+}
+
+TEST(decoded_feed, small_buffer) {
+  auto raw = "a\\nbcdefgh\\\\ij"sv;
+  using source_type = decltype(abu::feed::adapt_range(raw));
+  abu::feed::decoded_feed<source_type, decltype(&unescape)> sut{
+      abu::feed::adapt_range(raw), &unescape, 3};
+
+  auto cp = sut.checkpoint();
+  sut.advance(5);
+  auto cp2 = sut.checkpoint();
+  EXPECT_EQ(drain(sut), "efgh\\ij");
+
+  sut.rollback(cp2);
+  EXPECT_EQ(drain(sut), "efgh\\ij");
+  sut.rollback(cp);
+  EXPECT_EQ(drain(sut), "a\nbcdefgh\\ij");
+  EXPECT_EQ(sut, abu::feed::end_of_feed);
+}
+
+TEST(decoded_feed, stacked) {
+  auto sut = abu::feed::transform(
+      abu::feed::filter(abu::feed::adapt_range("a-b-c"sv),
+                        [](char c) { return c != '-'; }),
+      to_upper);
+
+  EXPECT_EQ(drain(sut), "ABC");
+}
@@ -0,0 +1,151 @@
+// Copyright 2021 Francois Chabot
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "abu/feed.h"
+#include "abu/feed/fd_reader.h"
+#include "gtest/gtest.h"
+
+namespace {
+struct test_pipe {
+  test_pipe() {
+    EXPECT_EQ(::pipe(fds), 0);
+  }
+
+  ~test_pipe() {
+    ::close(fds[0]);
+    if (fds[1] >= 0) {
+      ::close(fds[1]);
+    }
+  }
+
+  void write(const std::string& data) {
+    EXPECT_EQ(::write(fds[1], data.data(), data.size()),
+              static_cast<::ssize_t>(data.size()));
+  }
+
+  void close_write() {
+    ::close(fds[1]);
+    fds[1] = -1;
+  }
+
+  int fds[2];
+};
+
+template <typename StreamT>
+std::string drain(StreamT& data) {
+  std::string result;
+  while (data != abu::feed::empty) {
+    auto span = data.current_span();
+    result.append(span.begin(), span.end());
+    data.advance(std::ssize(span));
+  }
+  return result;
+}
+}  // namespace
+
+TEST(fd_reader, reads_in_batches) {
+  test_pipe pipe;
+  abu::feed::buffer_pool pool{4};
+  abu::feed::stream<abu::feed::pooled_buffer> data;
+  abu::feed::fd_reader sut{pipe.fds[0], pool, 4};
+
+  pipe.write("hello world");
+  EXPECT_EQ(sut.read_into(data), 11);
+  EXPECT_EQ(pool.capacity(), 4);
+  EXPECT_EQ(drain(data), "hello world");
+  EXPECT_NE(data, abu::feed::end_of_feed);
+
+  pipe.close_write();
+  EXPECT_EQ(sut.read_into(data), 0);
+  EXPECT_EQ(data, abu::feed::end_of_feed);
+}
+
+TEST(fd_reader, recycles_buffers) {
+  test_pipe pipe;
+  abu::feed::buffer_pool pool{16};
+  abu::feed::fd_reader sut{pipe.fds[0], pool};
+
+  {
+    abu::feed::stream<abu::feed::pooled_buffer> data;
+    for (int i = 0; i < 1000; ++i) {
+      pipe.write("0123456789");
+      EXPECT_EQ(sut.read_into(data), 10);
+      EXPECT_EQ(drain(data), "0123456789");
+    }
+
+    // Buffers only stay around for as long as they are reachable.
+    EXPECT_LE(pool.capacity(), abu::feed::fd_reader::default_max_batch + 1);
+  }
+  EXPECT_EQ(pool.free_count(), pool.capacity());
+}
+
+TEST(fd_reader, checkpoints_retain_buffers) {
+  test_pipe pipe;
+  abu::feed::buffer_pool pool{4};
+  abu::feed::stream<abu::feed::pooled_buffer> data;
+  abu::feed::fd_reader sut{pipe.fds[0], pool, 1};
+
+  auto cp = data.checkpoint();
+  for (int i = 0; i < 10; ++i) {
+    pipe.write("abcd");
+    sut.read_into(data);
+    drain(data);
+  }
+  EXPECT_GE(pool.capacity(), 10);
+
+  data.rollback(std::move(cp));
+  EXPECT_EQ(drain(data), "abcdabcdabcdabcdabcdabcdabcdabcdabcdabcd");
+}
+
+TEST(fd_reader, small_reads_use_fewer_buffers) {
+  test_pipe pipe;
+  abu::feed::buffer_pool pool{4};
+  abu::feed::stream<abu::feed::pooled_buffer> data;
+  abu::feed::fd_reader sut{pipe.fds[0], pool, 4};
+
+  // Keeps every buffer that makes it into the stream out of the pool.
+  auto cp = data.checkpoint();
+  for (int i = 0; i < 4; ++i) {
+    pipe.write("ab");
+    EXPECT_EQ(sut.read_into(data), 2);
+  }
+  EXPECT_EQ(pool.capacity(), 4);
+
+  // Full reads get more buffers again.
+  pipe.write("0123456789abcdef");
+  EXPECT_EQ(sut.read_into(data), 4);
+  EXPECT_EQ(sut.read_into(data), 8);
+  EXPECT_EQ(sut.read_into(data), 4);
+
+  data.rollback(std::move(cp));
+  EXPECT_EQ(drain(data), "abababab0123456789abcdef");
+}
+
+TEST(fd_reader, non_blocking) {
+  test_pipe pipe;
+  ::fcntl(pipe.fds[0], F_SETFL, ::fcntl(pipe.fds[0], F_GETFL) | O_NONBLOCK);
+
+  abu::feed::buffer_pool pool{4};
+  abu::feed::stream<abu::feed::pooled_buffer> data;
+  abu::feed::fd_reader sut{pipe.fds[0], pool};
+
+  EXPECT_EQ(sut.read_into(data), 0);
+  EXPECT_EQ(data, abu::feed::empty);
+  EXPECT_NE(data, abu::feed::end_of_feed);
+}
@@ -0,0 +1,187 @@
+// Copyright 2021 Francois Chabot
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "abu/feed.h"
+#include "gtest/gtest.h"
+
+using namespace std::literals;
+
+namespace {
+template <typename RopeT>
+std::string as_string(const RopeT& rope) {
+  std::string result;
+  rope.copy_to(std::back_inserter(result));
+  return result;
+}
+
+auto feed_read(abu::Feed auto& f) {
+  auto result = *f;
+  ++f;
+  return result;
+}
+
+using line_reader = abu::feed::frame_reader<
+    abu::feed::delimited_framing<char>,
+    std::string,
+    std::allocator<std::string>>;
+}  // namespace
+
+static_assert(abu::Feed<line_reader>);
+
+TEST(framing, delimited_within_chunk) {
+  abu::feed::stream<std::string> data;
+  data.append("ab\ncde\n");
+
+  abu::feed::frame_reader sut{data, abu::feed::delimited_framing{"\n"sv}};
+
+  auto first = feed_read(sut);
+  ASSERT_TRUE(first.is_contiguous());
+  EXPECT_EQ(as_string(first), "ab");
+
+  auto second = feed_read(sut);
+  ASSERT_TRUE(second.is_contiguous());
+  EXPECT_EQ(as_string(second), "cde");
+
+  // Frames point straight into the chunk.
+  EXPECT_EQ(second.span().data(), first.span().data() + 3);
+  EXPECT_TRUE(sut == abu::feed::empty);
+}
+
+TEST(framing, delimited_across_chunks) {
+  abu::feed::stream<std::string> data;
+  abu::feed::frame_reader sut{data, abu::feed::delimited_framing{"\r\n"sv}};
+
+  data.append("ab");
+  EXPECT_TRUE(sut == abu::feed::empty);
+
+  data.append("cd\r");
+  EXPECT_TRUE(sut == abu::feed::empty);
+
+  data.append("\nef\r\n");
+  auto frame = feed_read(sut);
+  EXPECT_FALSE(frame.is_contiguous());
+  EXPECT_EQ(as_string(frame), "abcd");
+
+  std::vector<std::string> pieces;
+  for (auto piece : frame.pieces()) {
+    pieces.emplace_back(piece.begin(), piece.end());
+  }
+  EXPECT_EQ(pieces, (std::vector<std::string>{"ab", "cd"}));
+
+  EXPECT_EQ(as_string(feed_read(sut)), "ef");
+  EXPECT_TRUE(sut == abu::feed::empty);
+}
+
+TEST(framing, delimited_last_frame) {
+  abu::feed::stream<std::string> data;
+  abu::feed::frame_reader sut{data, abu::feed::delimited_framing{"\r\n"sv}};
+
+  data.append("ab\r\ncd\r");
+  EXPECT_EQ(as_string(feed_read(sut)), "ab");
+  EXPECT_TRUE(sut == abu::feed::empty);
+  EXPECT_FALSE(sut == abu::feed::end_of_feed);
+
+  data.finish();
+  EXPECT_EQ(as_string(feed_read(sut)), "cd\r");
+  EXPECT_TRUE(sut == abu::feed::end_of_feed);
+}
+
+TEST(framing, frames_outlive_their_chunks) {
+  abu::feed::stream<std::vector<char>> data;
+  abu::feed::frame_reader sut{data, abu::feed::delimited_framing{"\n"sv}};
+
+  data.append({'a', 'b'});
+  data.append({'c', '\n', 'd'});
+  auto frame = feed_read(sut);
+
+  data.append({'\n'});
+  EXPECT_EQ(as_string(feed_read(sut)), "d");
+  EXPECT_EQ(as_string(frame), "abc");
+}
+
+TEST(framing, varint_length) {
+  abu::feed::stream<std::string> data;
+  abu::feed::frame_reader sut{data, abu::feed::varint_length_framing{}};
+
+  std::string big(300, 'x');
+  data.append("\x03"s + "abc" + "\xac");
+  EXPECT_EQ(as_string(feed_read(sut)), "abc");
+
+  // The size straddles chunks, then the payload does.
+  EXPECT_TRUE(sut == abu::feed::empty);
+  data.append("\x02" + big.substr(0, 100));
+  EXPECT_TRUE(sut == abu::feed::empty);
+  data.append(big.substr(100) + "\x00"s);
+
+  EXPECT_EQ(as_string(feed_read(sut)), big);
+  EXPECT_EQ(feed_read(sut).size(), 0);
+  EXPECT_TRUE(sut == abu::feed::empty);
+}
+
+TEST(framing, be32_length) {
+  abu::feed::stream<std::string> data;
+  abu::feed::frame_reader sut{data, abu::feed::be32_length_framing{}};
+
+  data.append("\0\0"s);
+  data.append("\0\x02hi\0\0\0\x03"s);
+  EXPECT_EQ(as_string(feed_read(sut)), "hi");
+  EXPECT_TRUE(sut == abu::feed::empty);
+
+  data.append("abc");
+  data.finish();
+  EXPECT_EQ(as_string(feed_read(sut)), "abc");
+  EXPECT_TRUE(sut == abu::feed::end_of_feed);
+}
+
+TEST(framing, errors) {
+  {
+    abu::feed::stream<std::string> data;
+    abu::feed::frame_reader sut{data, abu::feed::be32_length_framing{}};
+    data.append("\0\0\0\x05hi"s);
+    EXPECT_TRUE(sut == abu::feed::empty);
+
+    data.finish();
+    EXPECT_THROW((void)(sut == abu::feed::empty), abu::feed::framing_error);
+  }
+
+  {
+    abu::feed::stream<std::string> data;
+    abu::feed::frame_reader sut{data, abu::feed::varint_length_framing{16}};
+    data.append("\x80\x01");
+    EXPECT_THROW((void)(sut == abu::feed::empty), abu::feed::framing_error);
+  }
+
+  {
+    abu::feed::stream<std::string> data;
+    abu::feed::frame_reader sut{data,
+                                abu::feed::delimited_framing{"\n"sv, 4}};
+    data.append("abc");
+    EXPECT_TRUE(sut == abu::feed::empty);
+    data.append("de");
+    EXPECT_THROW((void)(sut == abu::feed::empty), abu::feed::framing_error);
+  }
+
+  {
+    // Ten bytes that don't fit in 64 bits, which can't be a size.
+    abu::feed::stream<std::string> data;
+    abu::feed::frame_reader sut{data, abu::feed::varint_length_framing{}};
+    data.append(std::string(9, '\xff') + "\x02");
+    EXPECT_THROW((void)(sut == abu::feed::empty), abu::feed::framing_error);
+  }
+}
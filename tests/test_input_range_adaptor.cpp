@@ -0,0 +1,182 @@
+// Copyright 2021 Francois Chabot
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <sstream>
+#include <type_traits>
+#include <vector>
+
+#include "abu/feed.h"
+#include "gtest/gtest.h"
+
+namespace {
+auto feed_read(abu::Feed auto& f) {
+  auto result = *f;
+  ++f;
+  return result;
+}
+}  // namespace
+
+TEST(input_range_adaptor, basic_api_test) {
+  std::istringstream raw_data("1 2 3 4");
+
+  auto sut = abu::feed::adapt_range(std::istream_iterator<int>{raw_data},
+                                    std::istream_iterator<int>{});
+
+  static_assert(abu::FeedOf<decltype(sut), int>);
+
+  EXPECT_NE(sut, abu::feed::empty);
+  EXPECT_EQ(feed_read(sut), 1);
+  EXPECT_EQ(feed_read(sut), 2);
+  EXPECT_EQ(feed_read(sut), 3);
+  EXPECT_EQ(feed_read(sut), 4);
+
+  EXPECT_EQ(sut, abu::feed::empty);
+  EXPECT_EQ(sut, abu::feed::end_of_feed);
+}
+
+TEST(input_range_adaptor, rollback) {
+  std::istringstream raw_data("1 2 3 4");
+
+  auto sut = abu::feed::adapt_range(std::istream_iterator<int>{raw_data},
+                                    std::istream_iterator<int>{});
+
+  auto cp = sut.checkpoint();
+
+  EXPECT_EQ(feed_read(sut), 1);
+  EXPECT_EQ(feed_read(sut), 2);
+  {
+    auto cp2 = sut.checkpoint();
+    EXPECT_EQ(feed_read(sut), 3);
+    sut.rollback(cp2);
+    EXPECT_EQ(feed_read(sut), 3);
+    sut.rollback(cp2);
+    EXPECT_EQ(feed_read(sut), 3);
+  }
+
+  sut.rollback(cp);
+
+  EXPECT_EQ(feed_read(sut), 1);
+  EXPECT_EQ(feed_read(sut), 2);
+  EXPECT_EQ(feed_read(sut), 3);
+  EXPECT_EQ(feed_read(sut), 4);
+
+  EXPECT_EQ(sut, abu::feed::empty);
+  EXPECT_EQ(sut, abu::feed::end_of_feed);
+}
+
+TEST(input_range_adaptor, rollback_across_chunks) {
+  std::istringstream raw_data("1 2 3 4 5 6 7");
+
+  abu::feed::input_range_adaptor sut{std::istream_iterator<int>{raw_data},
+                                     std::istream_iterator<int>{}, 2};
+
+  EXPECT_EQ(feed_read(sut), 1);
+
+  auto cp = sut.checkpoint();
+  EXPECT_EQ(feed_read(sut), 2);
+  EXPECT_EQ(feed_read(sut), 3);
+  EXPECT_EQ(feed_read(sut), 4);
+  EXPECT_EQ(feed_read(sut), 5);
+
+  sut.rollback(cp);
+  EXPECT_EQ(feed_read(sut), 2);
+  EXPECT_EQ(feed_read(sut), 3);
+
+  auto cp2 = sut.checkpoint();
+  cp = cp2;
+
+  EXPECT_EQ(feed_read(sut), 4);
+  EXPECT_EQ(feed_read(sut), 5);
+  EXPECT_EQ(feed_read(sut), 6);
+
+  sut.rollback(std::move(cp2));
+  EXPECT_EQ(feed_read(sut), 4);
+  EXPECT_EQ(feed_read(sut), 5);
+  EXPECT_EQ(feed_read(sut), 6);
+  EXPECT_EQ(feed_read(sut), 7);
+  EXPECT_EQ(sut, abu::feed::end_of_feed);
+
+  sut.rollback(cp);
+  EXPECT_EQ(feed_read(sut), 4);
+}
+
+TEST(input_range_adaptor, resumes_recording) {
+  std::istringstream raw_data("1 2 3 4 5 6");
+
+  abu::feed::input_range_adaptor sut{std::istream_iterator<int>{raw_data},
+                                     std::istream_iterator<int>{}, 2};
+
+  {
+    auto cp = sut.checkpoint();
+    EXPECT_EQ(feed_read(sut), 1);
+    EXPECT_EQ(feed_read(sut), 2);
+    EXPECT_EQ(feed_read(sut), 3);
+    sut.rollback(cp);
+  }
+
+  // Replaying from the buffer after the last checkpoint is gone.
+  EXPECT_EQ(feed_read(sut), 1);
+  EXPECT_EQ(feed_read(sut), 2);
+  EXPECT_EQ(feed_read(sut), 3);
+
+  EXPECT_EQ(feed_read(sut), 4);
+
+  auto cp = sut.checkpoint();
+  EXPECT_EQ(feed_read(sut), 5);
+  sut.rollback(cp);
+  EXPECT_EQ(feed_read(sut), 5);
+  EXPECT_EQ(feed_read(sut), 6);
+  EXPECT_EQ(sut, abu::feed::end_of_feed);
+}
+
+static_assert(!std::is_copy_constructible_v<
+              abu::feed::input_range_adaptor<std::istream_iterator<int>,
+                                             std::istream_iterator<int>>>);
+
+TEST(input_range_adaptor, buffer_is_released) {
+  auto value = std::make_shared<int>(0);
+  std::vector<std::shared_ptr<int>> raw_data(8, value);
+  auto baseline = value.use_count();
+
+  abu::feed::input_range_adaptor sut{raw_data.begin(), raw_data.end(), 2};
+
+  auto cp = std::make_optional(sut.checkpoint());
+  for (int i = 0; i < 6; ++i) {
+    feed_read(sut);
+  }
+  EXPECT_EQ(value.use_count(), baseline + 6);
+
+  // Only the chunk being written to is left.
+  cp.reset();
+  EXPECT_EQ(value.use_count(), baseline + 2);
+
+  // And it gets reused as soon as the adaptor moves on.
+  feed_read(sut);
+  EXPECT_EQ(value.use_count(), baseline);
+}
+
+TEST(input_range_adaptor, long_chain_release) {
+  auto values = std::views::iota(0, 1000000);
+  abu::feed::input_range_adaptor sut{values.begin(), values.end(), 1};
+
+  auto cp = std::make_optional(sut.checkpoint());
+  while (sut != abu::feed::empty) {
+    ++sut;
+  }
+  cp.reset();
+}
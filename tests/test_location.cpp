@@ -0,0 +1,151 @@
+// Copyright 2021 Francois Chabot
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cstddef>
+#include <list>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "abu/feed.h"
+#include "gtest/gtest.h"
+
+using namespace std::literals;
+
+namespace {
+template <typename F>
+concept has_offset = requires(const F& f) {
+  f.offset();
+};
+}  // namespace
+
+static_assert(has_offset<abu::feed::stream<std::string>>);
+static_assert(!has_offset<abu::feed::stream<std::list<char>>>);
+static_assert(!abu::feed::details_::line_countable<bool>);
+
+TEST(location, dense_newlines) {
+  // Long enough to fill the per-byte counters, at every alignment.
+  std::string text(5000, '\n');
+  for (std::size_t i = 3; i < text.size(); i += 7) {
+    text[i] = 'x';
+  }
+
+  for (std::size_t skip = 0; skip < 8; ++skip) {
+    auto data = std::string_view{text}.substr(skip);
+    auto expected = std::ranges::count(data, '\n');
+    auto lines =
+        abu::feed::details_::count_in_(std::span<const char>{data}, '\n');
+    EXPECT_EQ(lines, static_cast<std::size_t>(expected));
+  }
+}
+
+TEST(location, stream_offsets) {
+  abu::feed::stream<std::string> sut;
+  EXPECT_EQ(sut.offset(), 0);
+
+  auto start = sut.checkpoint();
+  sut.append("abc");
+  sut.append("de");
+  sut.advance(4);
+  EXPECT_EQ(sut.offset(), 4);
+
+  auto cp = sut.checkpoint();
+  sut.append("fgh");
+  sut.advance(2);
+  EXPECT_EQ(sut.offset(), 6);
+  EXPECT_EQ(sut.offset_of(cp), 4);
+  EXPECT_EQ(sut.offset_of(start), 0);
+
+  // Offsets survive the chunks they were taken in.
+  sut.rollback(cp);
+  EXPECT_EQ(sut.offset(), 4);
+}
+
+TEST(location, stream_offsets_of_scoped_checkpoints) {
+  abu::feed::stream<std::string> sut;
+  sut.append("abc");
+  sut.append("def");
+  sut.advance(1);
+
+  auto scope = sut.retain();
+  auto cp = sut.scoped_checkpoint();
+  sut.advance(4);
+  EXPECT_EQ(sut.offset_of(cp), 1);
+}
+
+TEST(location, stream_lines) {
+  abu::feed::stream<std::string> sut;
+  sut.track_lines();
+  EXPECT_EQ(sut.current_location(), (abu::feed::location{0, 1, 1}));
+
+  sut.append("ab\nc");
+  sut.append("d\n");
+  sut.append("\nefg");
+  sut.append("hi");
+
+  sut.advance(1);
+  EXPECT_EQ(sut.current_location(), (abu::feed::location{1, 1, 2}));
+  auto b = sut.checkpoint();
+
+  sut.advance(3);
+  EXPECT_EQ(sut.current_location(), (abu::feed::location{4, 2, 2}));
+
+  sut.advance(2);
+  EXPECT_EQ(sut.current_location(), (abu::feed::location{6, 3, 1}));
+
+  sut.advance(3);
+  EXPECT_EQ(sut.current_location(), (abu::feed::location{9, 4, 3}));
+
+  sut.advance(3);
+  EXPECT_EQ(sut.current_location(), (abu::feed::location{12, 4, 6}));
+  EXPECT_EQ(sut.location_of(b), (abu::feed::location{1, 1, 2}));
+}
+
+TEST(location, coalescing_stream_lines) {
+  abu::feed::coalescing_stream<std::string> sut{4};
+  sut.track_lines();
+
+  sut.append_copy("a\n"sv);
+  sut.append_copy("b"sv);
+  sut.append_copy("cd\ne"sv);
+  sut.advance(7);
+
+  EXPECT_EQ(sut.current_location(), (abu::feed::location{7, 3, 2}));
+}
+
+TEST(location, range_adaptor) {
+  auto data = "ab\ncd\n\nef"sv;
+  auto sut = abu::feed::adapt_range(data);
+  EXPECT_EQ(sut.offset(), 0);
+
+  auto cp = sut.checkpoint();
+  sut.advance(7);
+  EXPECT_EQ(sut.offset(), 7);
+  EXPECT_EQ(sut.offset_of(cp), 0);
+  EXPECT_EQ(sut.current_location(), (abu::feed::location{7, 4, 1}));
+
+  sut.advance(1);
+  EXPECT_EQ(sut.current_location(), (abu::feed::location{8, 4, 2}));
+  EXPECT_EQ(sut.location_of(cp), (abu::feed::location{0, 1, 1}));
+}
+
+TEST(location, non_contiguous_range_adaptor) {
+  std::list<int> data = {1, 2, 3};
+  auto sut = abu::feed::adapt_range(data);
+  ++sut;
+  ++sut;
+  EXPECT_EQ(sut.offset(), 2);
+}
@@ -0,0 +1,110 @@
+// Copyright 2021 Francois Chabot
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <string_view>
+
+#include "abu/feed.h"
+#include "gtest/gtest.h"
+
+using namespace std::literals;
+
+namespace {
+std::string_view as_string(std::span<const char> data) {
+  return {data.data(), data.size()};
+}
+}  // namespace
+
+TEST(lookahead, peek_within_chunk) {
+  abu::feed::stream<std::string> sut;
+  sut.append("abcd");
+
+  auto next = abu::feed::peek(sut, 3);
+  EXPECT_TRUE(next.ok());
+  EXPECT_EQ(as_string(next.data()), "abc");
+
+  // Points straight into the chunk.
+  EXPECT_EQ(next.data().data(), sut.current_span().data());
+  EXPECT_EQ(*sut, 'a');
+}
+
+TEST(lookahead, peek_across_chunks) {
+  abu::feed::stream<std::string> sut;
+  sut.append("ab");
+  sut.append("c");
+  sut.append("de");
+
+  auto next = sut.peek(4);
+  EXPECT_EQ(next.status(), abu::feed::peek_status::ok);
+  EXPECT_EQ(as_string(next.data()), "abcd");
+  EXPECT_EQ(next[3], 'd');
+  EXPECT_EQ(*sut, 'a');
+}
+
+TEST(lookahead, peek_not_enough_data) {
+  abu::feed::stream<std::string> sut;
+  sut.append("ab");
+
+  auto next = sut.peek(3);
+  EXPECT_EQ(next.status(), abu::feed::peek_status::need_more);
+  EXPECT_EQ(as_string(next.data()), "ab");
+
+  sut.finish();
+  next = sut.peek(3);
+  EXPECT_EQ(next.status(), abu::feed::peek_status::finished);
+  EXPECT_EQ(as_string(next.data()), "ab");
+}
+
+TEST(lookahead, matches) {
+  abu::feed::stream<std::string> sut;
+  sut.append("ab\r");
+
+  EXPECT_EQ(sut.matches("ab"sv), abu::feed::match_status::match);
+  EXPECT_EQ(sut.matches("ax"sv), abu::feed::match_status::mismatch);
+  EXPECT_EQ(sut.matches("ab\r\n"sv), abu::feed::match_status::need_more);
+  EXPECT_EQ(sut.matches("ab\n\r"sv), abu::feed::match_status::mismatch);
+
+  sut.append("\n");
+  EXPECT_EQ(sut.matches("ab\r\n"sv), abu::feed::match_status::match);
+  EXPECT_EQ(sut.matches("ab\r\nx"sv), abu::feed::match_status::need_more);
+
+  sut.finish();
+  EXPECT_EQ(sut.matches("ab\r\nx"sv), abu::feed::match_status::mismatch);
+}
+
+TEST(lookahead, generic_feeds) {
+  std::string data = "abcd";
+  auto sut = abu::feed::adapt_range(data);
+
+  EXPECT_EQ(as_string(abu::feed::peek(sut, 4).data()), "abcd");
+  EXPECT_EQ(abu::feed::peek(sut, 5).status(),
+            abu::feed::peek_status::finished);
+  EXPECT_EQ(abu::feed::matches(sut, "abc"sv), abu::feed::match_status::match);
+  EXPECT_EQ(abu::feed::matches(sut, "abcde"sv),
+            abu::feed::match_status::mismatch);
+
+  abu::feed::stream<std::string> stream;
+  stream.append("ab");
+  stream.append("cd");
+  abu::feed::any_feed<char> erased{std::ref(stream)};
+
+  auto next = abu::feed::peek(erased, 3);
+  EXPECT_TRUE(next.ok());
+  EXPECT_EQ(as_string(next.data()), "abc");
+  EXPECT_EQ(abu::feed::peek(erased, 5).status(),
+            abu::feed::peek_status::need_more);
+  EXPECT_EQ(abu::feed::matches(erased, "abcde"sv),
+            abu::feed::match_status::need_more);
+  EXPECT_EQ(*erased, 'a');
+}
@@ -0,0 +1,115 @@
+// Copyright 2021 Francois Chabot
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+
+#include "abu/feed.h"
+#include "abu/feed/mapped_file.h"
+#include "gtest/gtest.h"
+
+namespace {
+struct temp_file {
+  explicit temp_file(const std::string& contents)
+      : path(std::filesystem::temp_directory_path() /
+             ("abu_feed_test_" + std::to_string(::getpid()))) {
+    std::ofstream out(path, std::ios::binary);
+    out << contents;
+  }
+
+  ~temp_file() {
+    std::filesystem::remove(path);
+  }
+
+  std::filesystem::path path;
+};
+
+std::string make_contents(std::size_t len) {
+  std::string result;
+  for (std::size_t i = 0; i < len; ++i) {
+    result.push_back(static_cast<char>('a' + i % 26));
+  }
+  return result;
+}
+}  // namespace
+
+TEST(mapped_file, single_window) {
+  temp_file file{"hello"};
+
+  abu::feed::mapped_file sut{file.path.c_str()};
+  abu::feed::stream<abu::feed::mapped_window> data;
+
+  EXPECT_EQ(sut.size(), 5);
+  EXPECT_TRUE(sut.append_next_window(data));
+  EXPECT_TRUE(sut.done());
+  EXPECT_FALSE(sut.append_next_window(data));
+
+  std::string read;
+  while (data != abu::feed::empty) {
+    read.push_back(*data);
+    ++data;
+  }
+  EXPECT_EQ(data, abu::feed::end_of_feed);
+  EXPECT_EQ(read, "hello");
+}
+
+TEST(mapped_file, sliding_windows) {
+  auto contents = make_contents(10000);
+  temp_file file{contents};
+
+  // Rounded up to a single page.
+  abu::feed::mapped_file sut{file.path.c_str(), 1};
+  abu::feed::stream<abu::feed::mapped_window> data;
+  EXPECT_LT(sut.window_size(), contents.size());
+
+  auto cp = data.checkpoint();
+
+  int windows = 0;
+  std::string read;
+  while (sut.append_next_window(data)) {
+    ++windows;
+    while (data != abu::feed::empty) {
+      auto span = data.current_span();
+      read.append(span.begin(), span.end());
+      data.advance(std::ssize(span));
+    }
+  }
+
+  EXPECT_GT(windows, 1);
+  EXPECT_EQ(data, abu::feed::end_of_feed);
+  EXPECT_EQ(read, contents);
+
+  data.rollback(cp);
+  EXPECT_EQ(*data, 'a');
+}
+
+TEST(mapped_file, empty_file) {
+  temp_file file{""};
+
+  abu::feed::mapped_file sut{file.path.c_str()};
+  abu::feed::stream<abu::feed::mapped_window> data;
+
+  EXPECT_TRUE(sut.done());
+  EXPECT_TRUE(sut.append_next_window(data));
+  EXPECT_EQ(data, abu::feed::end_of_feed);
+}
+
+TEST(mapped_file, missing_file) {
+  EXPECT_THROW(abu::feed::mapped_file{"/this/file/does/not/exist"},
+               std::system_error);
+}
@@ -0,0 +1,199 @@
+// Copyright 2021 Francois Chabot
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <atomic>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "abu/feed.h"
+#include "gtest/gtest.h"
+
+using namespace std::literals;
+
+namespace {
+bool is_newline(char c) {
+  return c == '\n';
+}
+
+std::string drain(abu::Feed auto& data) {
+  std::string result;
+  while (data != abu::feed::empty) {
+    result.push_back(*data);
+    ++data;
+  }
+  return result;
+}
+
+std::size_t count_lines(abu::Feed auto& data) {
+  std::size_t result = 0;
+  while (data != abu::feed::empty) {
+    if (*data == '\n') {
+      ++result;
+    }
+    ++data;
+  }
+  return result;
+}
+
+std::string make_lines(std::size_t n) {
+  std::string result;
+  for (std::size_t i = 0; i < n; ++i) {
+    result += std::string(i % 7, 'a') + "\n";
+  }
+  return result;
+}
+}  // namespace
+
+static_assert(abu::ContiguousFeed<
+              abu::feed::stream<std::string>::rope_type::reader_type>);
+
+TEST(parallel, rope_reader) {
+  abu::feed::stream<std::string> data;
+  data.append("abc");
+  data.append("de");
+
+  auto rope = data.rope(5);
+  auto sut = rope.reader();
+  EXPECT_EQ(sut.current_span().size(), 3);
+
+  auto cp = sut.checkpoint();
+  sut.advance(4);
+  EXPECT_EQ(*sut, 'e');
+  sut.rollback(cp);
+  EXPECT_EQ(drain(sut), "abcde");
+  EXPECT_TRUE(sut == abu::feed::end_of_feed);
+}
+
+TEST(parallel, split_stream) {
+  abu::feed::stream<std::string> data;
+  data.append("ab\ncd");
+  data.append("e\nf\n");
+  data.append("gh");
+  data.finish();
+
+  auto segments = abu::feed::split(data, 3, is_newline);
+  ASSERT_EQ(segments.size(), 3);
+
+  std::vector<std::string> contents;
+  for (const auto& segment : segments) {
+    auto reader = segment.reader();
+    contents.push_back(drain(reader));
+  }
+  EXPECT_EQ(contents, (std::vector<std::string>{"ab\ncde\n", "f\n", "gh"}));
+
+  // The stream itself didn't move.
+  EXPECT_EQ(*data, 'a');
+}
+
+TEST(parallel, more_segments_than_records) {
+  abu::feed::stream<std::string> data;
+  data.append("a\nb");
+  data.finish();
+
+  auto segments = abu::feed::split(data, 8, is_newline);
+  ASSERT_EQ(segments.size(), 2);
+  EXPECT_EQ(segments[0].size(), 2);
+  EXPECT_EQ(segments[1].size(), 1);
+}
+
+TEST(parallel, split_range) {
+  auto text = make_lines(100);
+
+  auto segments = abu::feed::split(std::string_view{text}, 4, is_newline);
+  ASSERT_EQ(segments.size(), 4);
+
+  std::string joined;
+  for (auto segment : segments) {
+    EXPECT_EQ(segment.back(), '\n');
+    joined.append(segment.begin(), segment.end());
+  }
+  EXPECT_EQ(joined, text);
+}
+
+TEST(parallel, parse_in_parallel) {
+  auto text = make_lines(10000);
+
+  abu::feed::stream<std::string_view> data;
+  for (std::size_t i = 0; i < text.size(); i += 1000) {
+    data.append(std::string_view{text}.substr(i, 1000));
+  }
+  data.finish();
+
+  auto segments = abu::feed::split(data, 8, is_newline);
+  auto per_segment = abu::feed::parse_in_parallel(
+      segments, [](auto& feed) { return count_lines(feed); });
+  EXPECT_EQ(per_segment.size(), segments.size());
+
+  auto total = abu::feed::parse_in_parallel(
+      segments,
+      [](auto& feed) { return count_lines(feed); },
+      std::size_t{0},
+      std::plus<>{});
+  EXPECT_EQ(total, 10000);
+}
+
+TEST(parallel, no_segments) {
+  abu::feed::stream<std::string_view> data;
+  data.finish();
+
+  auto segments = abu::feed::split(data, 8, is_newline);
+  EXPECT_TRUE(segments.empty());
+
+  auto total = abu::feed::parse_in_parallel(
+      segments,
+      [](auto& feed) { return count_lines(feed); },
+      std::size_t{0},
+      std::plus<>{});
+  EXPECT_EQ(total, 0);
+}
+
+TEST(parallel, void_consumer) {
+  auto text = make_lines(1000);
+  auto segments = abu::feed::split(std::string_view{text}, 4, is_newline);
+
+  std::atomic<std::size_t> total = 0;
+  abu::feed::parse_in_parallel(
+      segments, [&](auto& feed) { total += count_lines(feed); });
+  EXPECT_EQ(total, 1000);
+}
+
+TEST(parallel, consumers_are_copied) {
+  auto text = make_lines(1000);
+  auto segments = abu::feed::split(std::string_view{text}, 4, is_newline);
+
+  auto calls = abu::feed::parse_in_parallel(
+      segments, [calls = 0](auto& feed) mutable {
+        count_lines(feed);
+        return ++calls;
+      });
+  EXPECT_EQ(calls, std::vector<int>(segments.size(), 1));
+}
+
+TEST(parallel, errors_are_rethrown) {
+  auto text = make_lines(100);
+  auto segments = abu::feed::split(std::string_view{text}, 4, is_newline);
+
+  EXPECT_THROW(abu::feed::parse_in_parallel(segments,
+                                            [](auto& feed) -> int {
+                                              if (*feed == 'a') {
+                                                throw std::runtime_error("");
+                                              }
+                                              return 0;
+                                            }),
+               std::runtime_error);
+}
@@ -0,0 +1,200 @@
+// Copyright 2021 Francois Chabot
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "abu/feed.h"
+#include "gtest/gtest.h"
+
+namespace {
+// Sums everything that shows up in its stream, in the README's resume()
+// style.
+struct summer {
+  bool resume() {
+    while (data != abu::feed::empty) {
+      total += *data;
+      ++data;
+    }
+    ++resumed;
+    return data == abu::feed::end_of_feed;
+  }
+
+  abu::feed::concurrent_stream<std::vector<int>> data;
+  long total = 0;
+  int resumed = 0;
+};
+}  // namespace
+
+TEST(scheduler, only_resumes_notified_consumers) {
+  abu::feed::resume_scheduler sut{2};
+  std::vector<summer> consumers(4);
+
+  std::vector<abu::feed::resume_scheduler::handle> ids;
+  for (auto& consumer : consumers) {
+    ids.push_back(sut.add([&] { consumer.resume(); }));
+  }
+
+  consumers[1].data.append({1, 2});
+  sut.notify(ids[1]);
+  consumers[3].data.append({3});
+  sut.notify(ids[3]);
+  sut.wait_idle();
+
+  EXPECT_EQ(consumers[0].resumed, 0);
+  EXPECT_EQ(consumers[1].resumed, 1);
+  EXPECT_EQ(consumers[1].total, 3);
+  EXPECT_EQ(consumers[2].resumed, 0);
+  EXPECT_EQ(consumers[3].resumed, 1);
+  EXPECT_EQ(consumers[3].total, 3);
+}
+
+TEST(scheduler, many_producers) {
+  constexpr std::size_t consumer_count = 64;
+  constexpr int chunk_count = 500;
+
+  abu::feed::resume_scheduler sut{4};
+  std::vector<summer> consumers(consumer_count);
+  std::vector<std::unique_ptr<std::atomic<int>>> in_flight;
+
+  std::vector<abu::feed::resume_scheduler::handle> ids;
+  std::atomic<int> overlaps = 0;
+  for (auto& consumer : consumers) {
+    auto& flag = *in_flight.emplace_back(std::make_unique<std::atomic<int>>(0));
+    ids.push_back(sut.add([&] {
+      if (flag.fetch_add(1) != 0) {
+        ++overlaps;
+      }
+      consumer.resume();
+      flag.fetch_sub(1);
+    }));
+  }
+
+  // One producer per half of the consumers, notifying after every chunk.
+  auto produce = [&](std::size_t first, std::size_t last) {
+    for (int i = 0; i < chunk_count; ++i) {
+      for (auto c = first; c < last; ++c) {
+        consumers[c].data.append({1, 2, 3});
+        sut.notify(ids[c]);
+      }
+    }
+    for (auto c = first; c < last; ++c) {
+      consumers[c].data.finish();
+      sut.notify(ids[c]);
+    }
+  };
+
+  std::thread producer{produce, 0, consumer_count / 2};
+  produce(consumer_count / 2, consumer_count);
+  producer.join();
+  sut.wait_idle();
+
+  EXPECT_EQ(overlaps, 0);
+  for (auto& consumer : consumers) {
+    EXPECT_EQ(consumer.total, chunk_count * 6);
+    EXPECT_EQ(consumer.data, abu::feed::end_of_feed);
+
+    // Notifications that pile up while a consumer is queued only get it
+    // resumed once.
+    EXPECT_LE(consumer.resumed, chunk_count + 1);
+  }
+}
+
+TEST(scheduler, notify_from_consumer) {
+  abu::feed::resume_scheduler sut{2};
+  int remaining = 100;
+
+  std::optional<abu::feed::resume_scheduler::handle> id;
+  id = sut.add([&] {
+    if (--remaining > 0) {
+      sut.notify(*id);
+    }
+  });
+
+  sut.notify(*id);
+  sut.wait_idle();
+  EXPECT_EQ(remaining, 0);
+}
+
+TEST(scheduler, remove) {
+  abu::feed::resume_scheduler sut{2};
+  summer kept;
+  summer removed;
+
+  auto kept_id = sut.add([&] { kept.resume(); });
+  auto removed_id = sut.add([&] { removed.resume(); });
+  sut.remove(removed_id);
+
+  kept.data.append({1});
+  sut.notify(kept_id);
+  sut.wait_idle();
+  EXPECT_EQ(kept.resumed, 1);
+  EXPECT_EQ(removed.resumed, 0);
+
+  // Consumers can remove themselves once they are done.
+  std::optional<abu::feed::resume_scheduler::handle> self_id;
+  int runs = 0;
+  self_id = sut.add([&] {
+    ++runs;
+    sut.remove(*self_id);
+  });
+  sut.notify(*self_id);
+  sut.wait_idle();
+  EXPECT_EQ(runs, 1);
+}
+
+TEST(scheduler, handles) {
+  std::optional<abu::feed::resume_scheduler> sut{std::in_place, 2};
+  int runs = 0;
+
+  auto id = sut->add([&] { ++runs; });
+  auto moved = std::move(id);
+  EXPECT_FALSE(id);
+  EXPECT_TRUE(moved);
+
+  sut->notify(moved);
+  sut->wait_idle();
+  EXPECT_EQ(runs, 1);
+
+  // Dropping the handle of a queued consumer leaves it to the workers.
+  {
+    auto dropped = sut->add([&] { ++runs; });
+    sut->notify(dropped);
+  }
+  sut->wait_idle();
+  EXPECT_LE(runs, 2);
+
+  sut->remove(moved);
+  EXPECT_FALSE(moved);
+
+  // Handles can outlive the scheduler.
+  auto kept = sut->add([] {});
+  sut.reset();
+}
+
+TEST(scheduler, errors) {
+  abu::feed::resume_scheduler sut{2};
+  auto id = sut.add([] { throw std::runtime_error("bad data"); });
+
+  sut.notify(id);
+  EXPECT_THROW(sut.wait_idle(), std::runtime_error);
+
+  // The error is only reported once.
+  EXPECT_NO_THROW(sut.wait_idle());
+}
@@ -0,0 +1,144 @@
+// Copyright 2021 Francois Chabot
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "abu/feed.h"
+#include "gtest/gtest.h"
+
+static_assert(abu::feed::details_::collect_stats,
+              "test_stats.cpp must be built against abu::instrumented::feed");
+
+namespace {
+auto feed_read(abu::Feed auto& f) {
+  auto result = *f;
+  ++f;
+  return result;
+}
+}  // namespace
+
+TEST(stream_stats, starts_empty) {
+  abu::feed::stream<std::vector<int>> data;
+
+  auto stats = data.stats();
+  EXPECT_EQ(stats.retained_chunks, 0);
+  EXPECT_EQ(stats.retained_elements, 0);
+  EXPECT_EQ(stats.live_checkpoints, 0);
+  EXPECT_EQ(stats.elements_consumed, 0);
+  EXPECT_EQ(stats.rollbacks, 0);
+}
+
+TEST(stream_stats, retention) {
+  abu::feed::stream<std::vector<int>> data;
+  data.append({1, 2, 3});
+  data.append({4, 5});
+
+  EXPECT_EQ(data.stats().retained_chunks, 2);
+  EXPECT_EQ(data.stats().retained_elements, 5);
+
+  // Leaving the first chunk behind releases it.
+  data.advance(3);
+  EXPECT_EQ(data.stats().retained_chunks, 1);
+  EXPECT_EQ(data.stats().retained_elements, 2);
+  EXPECT_EQ(data.stats().elements_consumed, 3);
+  EXPECT_EQ(data.stats().chunk_transitions, 2);
+}
+
+TEST(stream_stats, checkpoints_retain_chunks) {
+  abu::feed::stream<std::vector<int>> data;
+  data.append({1, 2, 3});
+
+  std::optional cp = data.checkpoint();
+  data.append({4, 5});
+  data.advance(4);
+
+  auto stats = data.stats();
+  EXPECT_EQ(stats.retained_chunks, 2);
+  EXPECT_EQ(stats.retained_elements, 5);
+  EXPECT_EQ(stats.live_checkpoints, 1);
+  EXPECT_EQ(stats.oldest_checkpoint_age, 4);
+
+  cp.reset();
+  stats = data.stats();
+  EXPECT_EQ(stats.retained_chunks, 1);
+  EXPECT_EQ(stats.live_checkpoints, 0);
+  EXPECT_EQ(stats.oldest_checkpoint_age, 0);
+}
+
+TEST(stream_stats, oldest_checkpoint) {
+  abu::feed::stream<std::vector<int>> data;
+  data.append({1, 2, 3, 4, 5, 6});
+
+  feed_read(data);
+  auto first = data.checkpoint();
+  feed_read(data);
+  std::optional second = data.checkpoint();
+  auto copy = *second;
+  data.advance(3);
+
+  EXPECT_EQ(data.stats().live_checkpoints, 3);
+  EXPECT_EQ(data.stats().oldest_checkpoint_age, 4);
+
+  data.rollback(std::move(first));
+  EXPECT_EQ(data.stats().live_checkpoints, 2);
+  EXPECT_EQ(data.stats().oldest_checkpoint_age, 0);
+
+  feed_read(data);
+  second.reset();
+  EXPECT_EQ(data.stats().live_checkpoints, 1);
+}
+
+TEST(stream_stats, rollbacks) {
+  abu::feed::stream<std::vector<int>> data;
+  data.append({1, 2, 3});
+  data.append({4, 5, 6});
+
+  auto cp = data.checkpoint();
+  data.advance(4);
+  data.rollback(cp);
+  data.advance(2);
+  data.rollback(std::move(cp));
+
+  auto stats = data.stats();
+  EXPECT_EQ(stats.rollbacks, 2);
+  EXPECT_EQ(stats.rollback_distance, 6);
+  EXPECT_EQ(stats.elements_consumed, 6);
+}
+
+TEST(stream_stats, coalesced_growth) {
+  abu::feed::coalescing_stream<std::string> data{16, 64};
+  data.append("ab");
+  data.append("cde");
+
+  auto stats = data.stats();
+  EXPECT_EQ(stats.retained_chunks, 1);
+  EXPECT_EQ(stats.retained_elements, 5);
+}
+
+TEST(stream_stats, scoped_rollbacks) {
+  abu::feed::stream<std::vector<int>> data;
+  data.append({1, 2, 3});
+
+  auto scope = data.retain();
+  auto cp = data.scoped_checkpoint();
+  data.advance(2);
+  data.rollback(cp);
+
+  auto stats = data.stats();
+  EXPECT_EQ(stats.live_checkpoints, 0);
+  EXPECT_EQ(stats.rollbacks, 1);
+  EXPECT_EQ(stats.rollback_distance, 2);
+}
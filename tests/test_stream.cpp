@@ -13,7 +13,12 @@
 // limitations under the License.
 
 #include <array>
+#include <iterator>
+#include <memory_resource>
 #include <numeric>
+#include <span>
+#include <string>
+#include <string_view>
 #include <vector>
 
 #include "abu/feed.h"
@@ -25,6 +30,40 @@ auto feed_read(abu::Feed auto& f) {
   ++f;
   return result;
 }
+
+struct allocation_counts {
+  int allocations = 0;
+  int deallocations = 0;
+};
+
+template <typename T>
+struct counting_allocator {
+  using value_type = T;
+
+  explicit counting_allocator(allocation_counts* c) : counts(c) {}
+
+  template <typename U>
+  counting_allocator(const counting_allocator<U>& other)
+      : counts(other.counts) {}
+
+  T* allocate(std::size_t n) {
+    ++counts->allocations;
+    return std::allocator<T>{}.allocate(n);
+  }
+
+  void deallocate(T* p, std::size_t n) {
+    ++counts->deallocations;
+    std::allocator<T>{}.deallocate(p, n);
+  }
+
+  bool operator==(const counting_allocator&) const = default;
+
+  allocation_counts* counts;
+};
+
+std::string_view as_view(std::span<const char> data) {
+  return {data.data(), data.size()};
+}
 }  // namespace
 
 TEST(single_chunk_stream, basic_api_test) {
@@ -167,3 +206,413 @@ TEST(stream, resume) {
   sut.finish();
   EXPECT_EQ(sut, abu::feed::end_of_feed);
 }
+
+TEST(stream, current_span) {
+  abu::feed::stream<std::vector<int>> sut;
+  EXPECT_TRUE(sut.current_span().empty());
+
+  sut.append({1, 2, 3});
+  sut.append({4, 5});
+
+  auto span = sut.current_span();
+  ASSERT_EQ(span.size(), 3);
+  EXPECT_EQ(span[0], 1);
+  EXPECT_EQ(span[2], 3);
+
+  ++sut;
+  EXPECT_EQ(sut.current_span().size(), 2);
+  EXPECT_EQ(sut.current_span()[0], 2);
+
+  sut.advance(2);
+  span = sut.current_span();
+  ASSERT_EQ(span.size(), 2);
+  EXPECT_EQ(span[0], 4);
+}
+
+TEST(stream, advance) {
+  abu::feed::stream<std::vector<int>> sut;
+  sut.append({1, 2});
+  sut.append({3, 4, 5});
+  sut.append({6});
+
+  auto cp = sut.checkpoint();
+
+  sut.advance(0);
+  EXPECT_EQ(*sut, 1);
+
+  sut.advance(3);
+  EXPECT_EQ(*sut, 4);
+
+  sut.advance(2);
+  EXPECT_EQ(*sut, 6);
+
+  sut.advance(1);
+  EXPECT_EQ(sut, abu::feed::empty);
+  EXPECT_NE(sut, abu::feed::end_of_feed);
+
+  sut.rollback(cp);
+  sut.advance(6);
+  EXPECT_EQ(sut, abu::feed::empty);
+
+  sut.append({7});
+  EXPECT_EQ(feed_read(sut), 7);
+
+  sut.rollback(cp);
+  EXPECT_DEATH(sut.advance(8), "past the available data");
+}
+
+TEST(stream, bulk_accumulate) {
+  abu::feed::stream<std::vector<int>> sut;
+  sut.append({1, 2});
+  sut.append({3, 4, 5});
+  sut.finish();
+
+  int accum = 0;
+  while (sut != abu::feed::end_of_feed) {
+    auto span = sut.current_span();
+    accum = std::accumulate(span.begin(), span.end(), accum);
+    sut.advance(std::ssize(span));
+  }
+
+  EXPECT_EQ(accum, 15);
+}
+
+TEST(stream, custom_allocator) {
+  allocation_counts counts;
+  {
+    using alloc_t = counting_allocator<std::vector<int>>;
+    abu::feed::stream<std::vector<int>, alloc_t> sut{alloc_t{&counts}};
+    EXPECT_EQ(counts.allocations, 1);
+
+    sut.append({1, 2});
+    sut.append({3, 4});
+    EXPECT_EQ(counts.allocations, 3);
+
+    // The initial placeholder node is not needed anymore.
+    EXPECT_EQ(counts.deallocations, 1);
+
+    auto cp = sut.checkpoint();
+    EXPECT_EQ(feed_read(sut), 1);
+    EXPECT_EQ(feed_read(sut), 2);
+    EXPECT_EQ(feed_read(sut), 3);
+    EXPECT_EQ(counts.deallocations, 1);
+
+    sut.rollback(std::move(cp));
+    EXPECT_EQ(feed_read(sut), 1);
+    EXPECT_EQ(feed_read(sut), 2);
+    EXPECT_EQ(feed_read(sut), 3);
+
+    // The first chunk is unreachable now.
+    EXPECT_EQ(counts.deallocations, 2);
+  }
+  EXPECT_EQ(counts.allocations, counts.deallocations);
+}
+
+TEST(stream, pooled_allocator) {
+  std::array<std::byte, 4096> buffer;
+  std::pmr::monotonic_buffer_resource upstream{
+      buffer.data(), buffer.size(), std::pmr::null_memory_resource()};
+  std::pmr::unsynchronized_pool_resource pool{&upstream};
+
+  abu::feed::stream<std::span<const int>,
+                    std::pmr::polymorphic_allocator<std::span<const int>>>
+      sut{&pool};
+
+  std::array<int, 3> data = {1, 2, 3};
+  int accum = 0;
+  for (int i = 0; i < 10000; ++i) {
+    sut.append(std::span<const int>{data});
+    while (sut != abu::feed::empty) {
+      accum += feed_read(sut);
+    }
+  }
+  sut.finish();
+
+  EXPECT_EQ(accum, 60000);
+  EXPECT_EQ(sut, abu::feed::end_of_feed);
+}
+
+TEST(stream, node_pool) {
+  abu::feed::node_pool pool{2};
+  using alloc_t = abu::feed::node_pool_allocator<std::vector<int>>;
+
+  {
+    abu::feed::stream<std::vector<int>, alloc_t> sut{&pool};
+    sut.append({1, 2});
+    auto cp = sut.checkpoint();
+    sut.append({3});
+    sut.append({4, 5});
+    sut.finish();
+
+    EXPECT_EQ(feed_read(sut), 1);
+    EXPECT_EQ(feed_read(sut), 2);
+    EXPECT_EQ(feed_read(sut), 3);
+    EXPECT_EQ(feed_read(sut), 4);
+    sut.rollback(cp);
+    EXPECT_EQ(feed_read(sut), 1);
+  }
+
+  abu::feed::stream<std::vector<int>, alloc_t> sut{&pool};
+  for (int i = 0; i < 1000; ++i) {
+    sut.append({i});
+    EXPECT_EQ(feed_read(sut), i);
+  }
+}
+
+TEST(stream, long_chain_release) {
+  auto sut = std::make_unique<abu::feed::stream<std::vector<int>>>();
+  auto cp = sut->checkpoint();
+  for (int i = 0; i < 1000000; ++i) {
+    sut->append({i});
+  }
+  sut.reset();
+}
+
+TEST(stream, scoped_checkpoint) {
+  abu::feed::stream<std::vector<int>> sut;
+  sut.append({1, 2});
+  sut.append({3, 4});
+
+  {
+    auto scope = sut.retain();
+    auto cp = sut.scoped_checkpoint();
+
+    EXPECT_EQ(feed_read(sut), 1);
+    auto cp2 = sut.scoped_checkpoint();
+    EXPECT_EQ(feed_read(sut), 2);
+    EXPECT_EQ(feed_read(sut), 3);
+
+    sut.rollback(cp2);
+    EXPECT_EQ(feed_read(sut), 2);
+
+    sut.rollback(cp);
+    EXPECT_EQ(feed_read(sut), 1);
+    EXPECT_EQ(feed_read(sut), 2);
+    EXPECT_EQ(feed_read(sut), 3);
+    EXPECT_EQ(feed_read(sut), 4);
+    EXPECT_EQ(sut, abu::feed::empty);
+
+    sut.rollback(cp);
+    EXPECT_EQ(feed_read(sut), 1);
+  }
+
+  EXPECT_EQ(feed_read(sut), 2);
+  EXPECT_EQ(feed_read(sut), 3);
+}
+
+TEST(stream, scoped_checkpoint_releases_chunks) {
+  allocation_counts counts;
+  counting_allocator<std::vector<int>> alloc{&counts};
+  abu::feed::stream<std::vector<int>, decltype(alloc)> sut{alloc};
+
+  sut.append({1, 2});
+  {
+    auto scope = sut.retain();
+    auto cp = sut.scoped_checkpoint();
+    sut.append({3, 4});
+    {
+      // Nested scopes don't retain anything more.
+      auto inner = sut.retain();
+      sut.advance(3);
+      EXPECT_EQ(counts.deallocations, 1);
+    }
+    EXPECT_EQ(counts.deallocations, 1);
+    sut.rollback(cp);
+    sut.advance(3);
+  }
+
+  // Only the placeholder and the first chunk are gone.
+  EXPECT_EQ(counts.deallocations, 2);
+  EXPECT_EQ(feed_read(sut), 4);
+}
+
+TEST(stream, scoped_checkpoint_across_append) {
+  abu::feed::stream<std::vector<int>> sut;
+  sut.append({1});
+
+  auto scope = sut.retain();
+  feed_read(sut);
+  auto cp = sut.scoped_checkpoint();
+  sut.append({2});
+  EXPECT_EQ(feed_read(sut), 2);
+
+  sut.rollback(cp);
+  EXPECT_EQ(feed_read(sut), 2);
+  EXPECT_EQ(sut, abu::feed::empty);
+}
+
+static_assert(abu::ContiguousFeed<
+              abu::feed::stream<std::vector<int>>::cursor_type>);
+
+TEST(stream, cursors_read_independently) {
+  abu::feed::stream<std::vector<int>> sut;
+  sut.append({1, 2});
+
+  auto a = sut.cursor();
+  EXPECT_EQ(feed_read(sut), 1);
+  auto b = sut.cursor();
+
+  sut.append({3});
+  sut.finish();
+
+  EXPECT_EQ(feed_read(a), 1);
+  EXPECT_EQ(feed_read(a), 2);
+  EXPECT_EQ(feed_read(a), 3);
+  EXPECT_EQ(a, abu::feed::end_of_feed);
+
+  EXPECT_EQ(feed_read(b), 2);
+  EXPECT_EQ(feed_read(sut), 2);
+  EXPECT_EQ(feed_read(b), 3);
+  EXPECT_EQ(b, abu::feed::end_of_feed);
+
+  EXPECT_EQ(feed_read(sut), 3);
+  EXPECT_EQ(sut, abu::feed::end_of_feed);
+}
+
+TEST(stream, cursor_catches_up) {
+  abu::feed::stream<std::vector<int>> sut;
+  auto cursor = sut.cursor();
+  EXPECT_EQ(cursor, abu::feed::empty);
+
+  sut.append({1});
+  EXPECT_NE(cursor, abu::feed::empty);
+  EXPECT_EQ(feed_read(cursor), 1);
+  EXPECT_EQ(cursor, abu::feed::empty);
+  EXPECT_NE(cursor, abu::feed::end_of_feed);
+
+  sut.append({2, 3});
+  cursor.advance(2);
+  sut.finish();
+  EXPECT_EQ(cursor, abu::feed::end_of_feed);
+}
+
+TEST(stream, cursor_checkpoints) {
+  abu::feed::stream<std::vector<int>> sut;
+  sut.append({1, 2});
+  sut.append({3, 4});
+
+  auto cursor = sut.cursor();
+  cursor.advance(1);
+  auto cp = cursor.checkpoint();
+  cursor.advance(2);
+  EXPECT_EQ(feed_read(cursor), 4);
+
+  cursor.rollback(std::move(cp));
+  EXPECT_EQ(feed_read(cursor), 2);
+
+  // The stream itself did not move.
+  EXPECT_EQ(feed_read(sut), 1);
+}
+
+TEST(stream, cursors_share_chunks) {
+  allocation_counts counts;
+  counting_allocator<std::vector<int>> alloc{&counts};
+  abu::feed::stream<std::vector<int>, decltype(alloc)> sut{alloc};
+
+  sut.append({1});
+  auto cursor = sut.cursor();
+  sut.append({2});
+  sut.append({3});
+
+  // The placeholder node is gone.
+  EXPECT_EQ(counts.allocations, 4);
+  EXPECT_EQ(counts.deallocations, 1);
+
+  sut.advance(2);
+  EXPECT_EQ(counts.deallocations, 1);
+
+  cursor.advance(2);
+  EXPECT_EQ(counts.deallocations, 3);
+
+  // Cursors outlive their stream.
+  auto moved = std::move(sut);
+  moved = decltype(sut){alloc};
+  EXPECT_EQ(feed_read(cursor), 3);
+}
+
+TEST(stream, cursor_over_coalescing_stream) {
+  abu::feed::coalescing_stream<std::string> sut{4, 16};
+  sut.append("ab");
+  auto cursor = sut.cursor();
+
+  sut.append("cd");
+  EXPECT_EQ(cursor.current_span().size(), 4);
+  cursor.advance(4);
+  EXPECT_EQ(cursor, abu::feed::empty);
+
+  sut.append("e");
+  EXPECT_EQ(feed_read(cursor), 'e');
+}
+
+TEST(stream, ropes) {
+  abu::feed::stream<std::vector<int>> sut;
+  sut.append({1, 2, 3});
+  sut.append({4, 5});
+
+  auto head = sut.rope(2);
+  ASSERT_TRUE(head.is_contiguous());
+  EXPECT_EQ(head.span().data(), sut.current_span().data());
+  EXPECT_EQ(sut.rope(5).size(), 5);
+  EXPECT_DEATH((void)sut.rope(6), "past the available data");
+
+  sut.advance(1);
+  auto across = sut.rope(3);
+  sut.advance(4);
+  EXPECT_EQ(sut, abu::feed::empty);
+
+  EXPECT_FALSE(across.is_contiguous());
+  EXPECT_EQ(std::ranges::distance(across.pieces()), 2);
+
+  std::vector<int> values;
+  across.copy_to(std::back_inserter(values));
+  EXPECT_EQ(values, (std::vector<int>{2, 3, 4}));
+}
+
+TEST(stream, slices) {
+  abu::feed::stream<std::string> sut;
+  sut.append("let ab");
+  sut.advance(4);
+
+  // The checkpoint sits at the end of its chunk once this is read.
+  auto start = sut.checkpoint();
+  sut.advance(2);
+  auto at_end = sut.checkpoint();
+  EXPECT_EQ(sut.distance(start, at_end), 2);
+  EXPECT_EQ(as_view(sut.slice(start, at_end).span()), "ab");
+  EXPECT_TRUE(sut.slice(start, start).empty());
+
+  sut.append("c = 1");
+  sut.advance(1);
+  auto across = sut.slice(start, sut.checkpoint());
+  auto within = sut.slice(at_end, sut.checkpoint());
+  EXPECT_EQ(sut.distance(sut.checkpoint(), start), -3);
+
+  // Slices keep their chunks alive.
+  sut.advance(4);
+  EXPECT_EQ(sut, abu::feed::empty);
+
+  std::string scratch;
+  EXPECT_FALSE(across.is_contiguous());
+  EXPECT_EQ(as_view(across.materialize(scratch)), "abc");
+  EXPECT_EQ(scratch, "abc");
+
+  ASSERT_TRUE(within.is_contiguous());
+  EXPECT_EQ(as_view(within.materialize(scratch)), "c");
+  EXPECT_NE(within.materialize(scratch).data(), scratch.data());
+}
+
+TEST(stream, slices_of_scoped_checkpoints) {
+  abu::feed::stream<std::string> sut;
+  sut.append("ab");
+  sut.append("cd");
+
+  auto scope = sut.retain();
+  auto start = sut.scoped_checkpoint();
+  sut.advance(3);
+  auto slice = sut.slice(start, sut.scoped_checkpoint());
+  EXPECT_EQ(slice.size(), 3);
+
+  std::string values;
+  slice.copy_to(std::back_inserter(values));
+  EXPECT_EQ(values, "abc");
+}
@@ -0,0 +1,191 @@
+// Copyright 2021 Francois Chabot
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "abu/feed.h"
+#include "gtest/gtest.h"
+
+using namespace std::literals;
+
+namespace {
+template <typename F>
+std::string drain(F& data) {
+  std::string result;
+  while (data != abu::feed::empty) {
+    result.push_back(static_cast<char>(*data));
+    ++data;
+  }
+  return result;
+}
+
+template <typename F>
+std::u32string drain_code_points(F& data) {
+  std::u32string result;
+  while (data != abu::feed::empty) {
+    result.push_back(*data);
+    ++data;
+  }
+  return result;
+}
+
+bool is_valid(std::string_view text) {
+  auto data = abu::feed::adapt_range(text);
+  auto sut = abu::feed::validate_utf8(std::ref(data));
+  try {
+    drain(sut);
+  } catch (const abu::feed::utf8_error&) {
+    return false;
+  }
+  return sut == abu::feed::end_of_feed;
+}
+}  // namespace
+
+static_assert(abu::ContiguousFeed<decltype(abu::feed::validate_utf8(
+                  abu::feed::adapt_range(""sv)))>);
+static_assert(abu::FeedOf<decltype(abu::feed::decode_utf8(
+                              abu::feed::adapt_range(""sv))),
+                          char32_t>);
+
+TEST(utf8, validation) {
+  EXPECT_TRUE(is_valid(""));
+  EXPECT_TRUE(is_valid("plain ascii, long enough for the fast path"));
+  EXPECT_TRUE(is_valid("h\xc3\xa9llo \xe2\x82\xac \xf0\x9f\x98\x80"));
+  EXPECT_TRUE(is_valid("\xed\x9f\xbf\xf4\x8f\xbf\xbf"));
+
+  // Stray continuation, overlong forms, surrogates and values past U+10FFFF.
+  EXPECT_FALSE(is_valid("ab\x80"));
+  EXPECT_FALSE(is_valid("\xc0\xaf"));
+  EXPECT_FALSE(is_valid("\xe0\x80\xaf"));
+  EXPECT_FALSE(is_valid("\xed\xa0\x80"));
+  EXPECT_FALSE(is_valid("\xf4\x90\x80\x80"));
+  EXPECT_FALSE(is_valid("\xf5\x80\x80\x80"));
+  EXPECT_FALSE(is_valid("\xe2\x28\xa1"));
+
+  // Truncated at the end.
+  EXPECT_FALSE(is_valid("ab\xe2\x82"));
+}
+
+TEST(utf8, validation_of_long_text) {
+  std::string text;
+  for (int i = 0; i < 20; ++i) {
+    text += "caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80 ";
+    text += "and some plain ascii filler, more than a block of it";
+  }
+  text += "\xf0\x9f\x98\x80";
+  EXPECT_TRUE(is_valid(text));
+
+  // Errors, wherever they are.
+  for (auto pos : {std::size_t{3}, text.size() / 2, text.size() - 3}) {
+    auto broken = text;
+    broken[pos] = '\xff';
+    EXPECT_FALSE(is_valid(broken));
+  }
+
+  auto scan = abu::feed::details_::scan_utf8(
+      std::span<const char>{text.data(), text.size() - 2});
+  EXPECT_EQ(scan.status, abu::feed::details_::utf8_status::incomplete);
+  EXPECT_EQ(scan.valid, text.size() - 4);
+}
+
+TEST(utf8, errors_are_reported_in_place) {
+  auto data = abu::feed::adapt_range("ab\xff"sv);
+  auto sut = abu::feed::validate_utf8(std::ref(data));
+
+  EXPECT_EQ(sut.current_span().size(), 2);
+  sut.advance(2);
+  EXPECT_THROW((void)(sut == abu::feed::empty), abu::feed::utf8_error);
+}
+
+TEST(utf8, validated_across_chunks) {
+  abu::feed::stream<std::string> data;
+  auto sut = abu::feed::validate_utf8(std::ref(data));
+
+  data.append("a\xe2");
+  EXPECT_EQ(sut.current_span().size(), 1);
+  EXPECT_EQ(drain(sut), "a");
+
+  // Truncated sequences are waited for.
+  EXPECT_EQ(sut, abu::feed::empty);
+  data.append("\x82");
+  EXPECT_EQ(sut, abu::feed::empty);
+
+  data.append("\xac!");
+  EXPECT_EQ(drain(sut), "\xe2\x82\xac!");
+
+  data.append("\xc3");
+  EXPECT_EQ(sut, abu::feed::empty);
+  data.finish();
+  EXPECT_THROW((void)(sut == abu::feed::empty), abu::feed::utf8_error);
+}
+
+TEST(utf8, validated_rollback) {
+  abu::feed::stream<std::string> data;
+  auto sut = abu::feed::validate_utf8(std::ref(data));
+
+  data.append("x\xc3");
+  data.append("\xa9y");
+  data.finish();
+
+  ++sut;
+  auto cp = sut.checkpoint();
+  EXPECT_EQ(drain(sut), "\xc3\xa9y");
+  EXPECT_EQ(sut, abu::feed::end_of_feed);
+
+  sut.rollback(cp);
+  EXPECT_EQ(drain(sut), "\xc3\xa9y");
+}
+
+TEST(utf8, decoding) {
+  auto data = abu::feed::adapt_range(
+      "ascii run of more than eight \xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80"sv);
+  auto sut = abu::feed::decode_utf8(std::ref(data));
+
+  EXPECT_EQ(drain_code_points(sut),
+            U"ascii run of more than eight é€\U0001F600");
+  EXPECT_EQ(sut, abu::feed::end_of_feed);
+}
+
+TEST(utf8, decoding_across_chunks) {
+  abu::feed::stream<std::vector<char8_t>> data;
+  auto sut = abu::feed::decode_utf8(std::ref(data));
+
+  data.append({u8'a', 0xf0, 0x9f});
+  EXPECT_EQ(drain_code_points(sut), U"a");
+  EXPECT_EQ(sut, abu::feed::empty);
+
+  data.append({0x98});
+  EXPECT_EQ(sut, abu::feed::empty);
+  data.append({0x80, 0xe2, 0x82});
+  EXPECT_EQ(drain_code_points(sut), U"\U0001F600");
+
+  data.finish();
+  EXPECT_THROW((void)(sut == abu::feed::empty), abu::feed::utf8_error);
+}
+
+TEST(utf8, decoding_errors_are_reported_in_place) {
+  auto data = abu::feed::adapt_range("ab\xc3\x28"sv);
+  auto sut = abu::feed::decode_utf8(std::ref(data));
+
+  EXPECT_EQ(*sut, U'a');
+  ++sut;
+  EXPECT_EQ(*sut, U'b');
+  ++sut;
+  EXPECT_THROW((void)(sut == abu::feed::empty), abu::feed::utf8_error);
+}